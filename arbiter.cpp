@@ -0,0 +1,92 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <thread>
+#include "matcharbiter.h"
+
+// Engine-vs-engine arbiter: plays every pair of protocol engines against each
+// other, many matches at once, and reports per-engine strength and latency.
+//
+//   battleship_arbiter --engine expert="battleship_headless --engine --difficulty Expert"
+//                      --engine mine=./my_engine --games 200 --concurrency 64
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("battleship_arbiter");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Plays protocol engines against each other.");
+    parser.addHelpOption();
+    QCommandLineOption engineOption("engine", "Engine to play, as name=command. Give at least two.", "name=command");
+    QCommandLineOption rulesOption("rules", "Rule set: classic, compact[:ships] or RxC:len,len,...", "spec", "classic");
+    QCommandLineOption gamesOption("games", "Games per pair of engines.", "n", "100");
+    QCommandLineOption matchGamesOption("games-per-match", "Games one pair of engine processes plays before restarting.",
+                                        "n", "10");
+    QCommandLineOption concurrencyOption("concurrency", "Matches running at once.", "n",
+                                         QString::number(qMax(1u, std::thread::hardware_concurrency())));
+    QCommandLineOption moveTimeOption("move-time", "Time limit per reply in milliseconds.", "ms", "1000");
+    QCommandLineOption logOption("log", "Write every game's moves to a file.", "file");
+    QCommandLineOption ratingsOption("ratings", "Add the results to a rating ladder log and print its leaderboard.",
+                                     "file");
+    parser.addOptions({engineOption, rulesOption, gamesOption, matchGamesOption, concurrencyOption, moveTimeOption,
+                       logOption, ratingsOption});
+    parser.process(app);
+
+    QVector<ArbiterEngine> engines;
+    for (const QString &spec : parser.values(engineOption)) {
+        int split = spec.indexOf('=');
+        if (split <= 0) {
+            qWarning("Engine %s is not name=command", qPrintable(spec));
+            return 1;
+        }
+        engines.append(ArbiterEngine{spec.left(split), spec.mid(split + 1)});
+    }
+    if (engines.size() < 2) {
+        qWarning("Give at least two engines");
+        return 1;
+    }
+
+    bool rulesOk = false;
+    RuleSet rules = RuleSet::parse(parser.value(rulesOption), &rulesOk);
+    if (!rulesOk || rules.isSalvo()) {
+        qWarning("Invalid rule set %s", qPrintable(parser.value(rulesOption)));
+        return 1;
+    }
+
+    RatingLadder ladder;
+    if (parser.isSet(ratingsOption) && !ladder.open(parser.value(ratingsOption))) {
+        qWarning("%s is not a rating ladder log", qPrintable(parser.value(ratingsOption)));
+        return 1;
+    }
+
+    QStringList moveLog;
+    MatchArbiter arbiter(engines, rules);
+    arbiter.setConcurrency(parser.value(concurrencyOption).toInt());
+    arbiter.setMoveTime(parser.value(moveTimeOption).toInt());
+    arbiter.setGamesPerMatch(parser.value(matchGamesOption).toInt());
+    if (parser.isSet(logOption)) arbiter.setMoveLog(&moveLog);
+    if (ladder.isOpen()) arbiter.setRatingLadder(&ladder);
+    arbiter.run(qMax(1, parser.value(gamesOption).toInt()));
+
+    QTextStream out(stdout);
+    out << arbiter.toText();
+    if (ladder.isOpen()) {
+        out << "\n" << ladder.toText();
+        if (!ladder.close()) {
+            qWarning("Could not write %s", qPrintable(parser.value(ratingsOption)));
+            return 1;
+        }
+    }
+    out.flush();
+
+    if (parser.isSet(logOption)) {
+        QFile file(parser.value(logOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            qWarning("Could not write %s", qPrintable(parser.value(logOption)));
+            return 1;
+        }
+        QTextStream(&file) << moveLog.join("\n") << "\n";
+    }
+    return 0;
+}
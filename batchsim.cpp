@@ -0,0 +1,152 @@
+#include "batchsim.h"
+#include "enginerandom.h"
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BATCHSIM_X86 1
+#include <immintrin.h>
+#endif
+
+// One attack step for every lane: count the shot if the game is still going,
+// then take one ship cell off if it hit. Written without branches or compares
+// so the SIMD versions are the same arithmetic:
+//   active = (0 - remaining) >> 63   (remaining is small and non-negative)
+//   hit    = (ships >> bit) & 1
+static void stepScalar(const quint64 *ships, int bit, quint64 *remaining, quint64 *shots) {
+    for (int lane = 0; lane < BatchSimulator::LANES; ++lane) {
+        shots[lane] += (0 - remaining[lane]) >> 63;
+        remaining[lane] -= (ships[lane] >> bit) & 1;
+    }
+}
+
+#ifdef BATCHSIM_X86
+__attribute__((target("sse2")))
+static void stepSse2(const quint64 *ships, int bit, quint64 *remaining, quint64 *shots) {
+    const __m128i one = _mm_set1_epi64x(1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i shift = _mm_cvtsi32_si128(bit);
+    const __m128i sign = _mm_cvtsi32_si128(63);
+    for (int lane = 0; lane < BatchSimulator::LANES; lane += 2) {
+        __m128i left = _mm_load_si128(reinterpret_cast<const __m128i *>(remaining + lane));
+        __m128i count = _mm_load_si128(reinterpret_cast<const __m128i *>(shots + lane));
+        __m128i cells = _mm_load_si128(reinterpret_cast<const __m128i *>(ships + lane));
+        count = _mm_add_epi64(count, _mm_srl_epi64(_mm_sub_epi64(zero, left), sign));
+        left = _mm_sub_epi64(left, _mm_and_si128(_mm_srl_epi64(cells, shift), one));
+        _mm_store_si128(reinterpret_cast<__m128i *>(remaining + lane), left);
+        _mm_store_si128(reinterpret_cast<__m128i *>(shots + lane), count);
+    }
+}
+
+__attribute__((target("avx2")))
+static void stepAvx2(const quint64 *ships, int bit, quint64 *remaining, quint64 *shots) {
+    const __m256i one = _mm256_set1_epi64x(1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m128i shift = _mm_cvtsi32_si128(bit);
+    const __m128i sign = _mm_cvtsi32_si128(63);
+    for (int lane = 0; lane < BatchSimulator::LANES; lane += 4) {
+        __m256i left = _mm256_load_si256(reinterpret_cast<const __m256i *>(remaining + lane));
+        __m256i count = _mm256_load_si256(reinterpret_cast<const __m256i *>(shots + lane));
+        __m256i cells = _mm256_load_si256(reinterpret_cast<const __m256i *>(ships + lane));
+        count = _mm256_add_epi64(count, _mm256_srl_epi64(_mm256_sub_epi64(zero, left), sign));
+        left = _mm256_sub_epi64(left, _mm256_and_si256(_mm256_srl_epi64(cells, shift), one));
+        _mm256_store_si256(reinterpret_cast<__m256i *>(remaining + lane), left);
+        _mm256_store_si256(reinterpret_cast<__m256i *>(shots + lane), count);
+    }
+}
+#endif
+
+BatchSimulator::BatchSimulator(const RuleSet &rules, Kernel kernel)
+    : rules(rules), activeKernel(isSupported(kernel) ? kernel : Scalar),
+    words((rules.cells() + 63) / 64)
+{
+    memset(shipWords, 0, sizeof(shipWords));
+    for (int shipLength : rules.shipLengths) {
+        placements.append(shipPositions(rules, shipLength));
+    }
+}
+
+BatchSimulator::Kernel BatchSimulator::bestKernel() {
+    if (isSupported(Avx2)) return Avx2;
+    if (isSupported(Sse2)) return Sse2;
+    return Scalar;
+}
+
+bool BatchSimulator::isSupported(Kernel kernel) {
+    switch (kernel) {
+#ifdef BATCHSIM_X86
+    case Avx2: return __builtin_cpu_supports("avx2");
+    case Sse2: return __builtin_cpu_supports("sse2");
+#endif
+    case Scalar: return true;
+    default: return false;
+    }
+}
+
+const char *BatchSimulator::kernelName(Kernel kernel) {
+    switch (kernel) {
+    case Avx2: return "avx2";
+    case Sse2: return "sse2";
+    default: return "scalar";
+    }
+}
+
+// Parity lattice ((row + col) even) in random order, then the other cells.
+QVector<int> BatchSimulator::shotOrder(const RuleSet &rules) {
+    QVector<int> order;
+    for (int parity = 0; parity < 2; ++parity) {
+        int start = order.size();
+        for (int cell = 0; cell < rules.cells(); ++cell) {
+            if ((cell / rules.cols + cell % rules.cols) % 2 == parity) order.append(cell);
+        }
+        for (int i = order.size() - 1; i > start; --i) {
+            qSwap(order[i], order[start + engineRandom(i - start + 1)]);
+        }
+    }
+    return order;
+}
+
+BatchSimulator::Kernel BatchSimulator::kernel() const {
+    return activeKernel;
+}
+
+// Random non-overlapping fleet per lane from the precomputed positions,
+// written straight into the lane masks.
+void BatchSimulator::deal() {
+    for (int lane = 0; lane < LANES; ++lane) {
+        CellMask fleet;
+        for (const QVector<CellMask> &positions : placements) {
+            const CellMask *ship;
+            do {
+                ship = &positions[engineRandom(positions.size())];
+            } while (!(*ship & fleet).isEmpty());
+            fleet |= *ship;
+        }
+        for (int w = 0; w < words; ++w) shipWords[w][lane] = fleet.words[w];
+        remaining[lane] = rules.fleetCells();
+        shotCounts[lane] = 0;
+    }
+}
+
+void BatchSimulator::playBatch(quint64 shots[LANES]) {
+    deal();
+    QVector<int> order = shotOrder(rules);
+
+    void (*step)(const quint64 *, int, quint64 *, quint64 *) = stepScalar;
+#ifdef BATCHSIM_X86
+    if (activeKernel == Avx2) step = stepAvx2;
+    else if (activeKernel == Sse2) step = stepSse2;
+#endif
+
+    for (int i = 0; i < order.size(); ++i) {
+        int cell = order[i];
+        step(shipWords[cell >> 6], cell & 63, remaining, shotCounts);
+
+        // Stop once every fleet is gone; checking each step costs more than it saves
+        if ((i & 15) == 15) {
+            quint64 left = 0;
+            for (int lane = 0; lane < LANES; ++lane) left |= remaining[lane];
+            if (!left) break;
+        }
+    }
+    memcpy(shots, shotCounts, sizeof(shotCounts));
+}
@@ -0,0 +1,44 @@
+#ifndef BATCHSIM_H
+#define BATCHSIM_H
+
+#include <QVector>
+#include "board.h"
+
+// Plays LANES independent games in lockstep for parameter sweeps. Each game's
+// fleet is a bitmask stored struct-of-arrays (word w of every lane side by
+// side), so one attack step is a handful of vector ops across all games.
+//
+// The bot is deliberately simple so it vectorises: every lane fires the same
+// shot order, a shuffled parity lattice followed by the remaining cells. Only
+// the fleets differ between lanes.
+class BatchSimulator {
+public:
+    enum Kernel { Scalar, Sse2, Avx2 };
+    static const int LANES = 64;
+
+    explicit BatchSimulator(const RuleSet &rules, Kernel kernel = bestKernel());
+
+    static Kernel bestKernel();
+    static bool isSupported(Kernel kernel);
+    static const char *kernelName(Kernel kernel);
+    static QVector<int> shotOrder(const RuleSet &rules);
+
+    Kernel kernel() const;
+    // Deals fresh fleets and plays them out; shots[i] is what game i took.
+    void playBatch(quint64 shots[LANES]);
+
+private:
+    enum { MAX_WORDS = CellMask::WORDS };
+
+    RuleSet rules;
+    Kernel activeKernel;
+    int words;
+    QVector<QVector<CellMask>> placements; // every position of each ship in rules.shipLengths
+    alignas(32) quint64 shipWords[MAX_WORDS][LANES];
+    alignas(32) quint64 remaining[LANES]; // unhit ship cells per game
+    alignas(32) quint64 shotCounts[LANES];
+
+    void deal();
+};
+
+#endif // BATCHSIM_H
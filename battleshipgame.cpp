@@ -6,81 +6,98 @@
 #include <QSpinBox>
 #include <QGroupBox>
 #include <QMessageBox>
+#include <QPlainTextEdit>
+#include <QCheckBox>
+#include <QDir>
+#include <QStandardPaths>
+#include <QTimer>
+#include "enginerandom.h"
+#include "latencyprobe.h"
+#include "startupprofile.h"
+#include "tracing.h"
 
 
 
 BattleshipGame::BattleshipGame(QWidget *parent)
     : QMainWindow(parent),
-    numShips(3),
     currentShip(0),
     isPlacingShips(true), gameOver(false), difficulty("Easy"),
-    lastHit(-1, -1),
     gamePhase(PlacingShips),
     currentShipPlayer1(0), currentShipPlayer2(0),
-    currentPlayer(1)
+    currentPlayer(1), profileLoaded(false), firstPaintSeen(false)
 {
-    srand(static_cast<unsigned int>(time(nullptr)));
-    createIcons();
+    uiEvents = events.subscribe();
+    seedEngineRandom(static_cast<quint32>(time(nullptr)));
     showStartupDialog();
 
-    // Now numShips has been set in showStartupDialog()
-    // So initialize the boards
-    userBoard = Board(numShips);
-    botBoard = Board(numShips);
-    player1Board = Board(numShips);
-    player2Board = Board(numShips);
-    int size = 5; // For example, a vector of size 5
-QVector<QPair<int, int>> probabilityVector(size, QPair<int, int>(0, 0)); // All pairs initialized to (0, 0)
-
-
-    setupUI();
+    // Now rules has been set in showStartupDialog()
+    // So initialize the boards this mode plays on. The bot's fleet (and the
+    // profile it is placed against) waits until the user has placed theirs.
     if (currentMode == SinglePlayer) {
-        botPlaceShips();
+        userBoard = Board(rules);
+        botBoard = Board(rules);
+    } else {
+        player1Board = Board(rules);
+        player2Board = Board(rules);
     }
-}
-
-void BattleshipGame::createIcons() {
-    QPixmap oceanPixmap(50, 50);
-    oceanPixmap.fill(Qt::blue);
-    oceanIcon = QIcon(oceanPixmap);
-
-    QPixmap shipPixmap(50, 50);
-    shipPixmap.fill(Qt::green);
-    shipIcon = QIcon(shipPixmap);
-
-    QPixmap hitPixmap(50, 50);
-    hitPixmap.fill(Qt::red);
-    QPainter hitPainter(&hitPixmap);
-    hitPainter.setPen(QPen(Qt::white, 5));
-    hitPainter.drawLine(0, 0, 50, 50);
-    hitPainter.drawLine(50, 0, 0, 50);
-    hitPainter.end();
-    hitIcon = QIcon(hitPixmap);
+    bot = BotPlayer(BotPlayer::difficultyFromName(difficulty));
+    StartupProfile::mark("engine state");
 
-    QPixmap missPixmap(50, 50);
-    missPixmap.fill(Qt::gray);
-    missIcon = QIcon(missPixmap);
-
-
-    QPixmap leftPixmap(":/icons/left.png");
-    QPixmap middlePixmap(":/icons/middle.png");
-    QPixmap rightPixmap(":/icons/right.png");
-
-
-    leftShipIcon = QIcon(leftPixmap);
-    middleShipIcon = QIcon(middlePixmap);
-    rightShipIcon = QIcon(rightPixmap);
+    setupUI();
+    StartupProfile::mark("main window UI");
+}
 
+const QIcon &BattleshipGame::icon(GameIcon kind) {
+    if (icons[kind].isNull()) {
+        icons[kind] = createIcon(kind);
+    }
+    return icons[kind];
+}
 
-    QTransform transform;
-    transform.rotate(90);
-    QPixmap upperPixmap = leftPixmap.transformed(transform);
-    QPixmap middleVerticalPixmap = middlePixmap.transformed(transform);
-    QPixmap lowerPixmap = rightPixmap.transformed(transform);
+QIcon BattleshipGame::createIcon(GameIcon kind) {
+    QPixmap pixmap(50, 50);
+    switch (kind) {
+    case OceanIcon:
+        pixmap.fill(Qt::blue);
+        break;
+    case ShipIcon:
+        pixmap.fill(Qt::green);
+        break;
+    case HitIcon: {
+        pixmap.fill(Qt::red);
+        QPainter hitPainter(&pixmap);
+        hitPainter.setPen(QPen(Qt::white, 5));
+        hitPainter.drawLine(0, 0, 50, 50);
+        hitPainter.drawLine(50, 0, 0, 50);
+        hitPainter.end();
+        break;
+    }
+    case MissIcon:
+        pixmap.fill(Qt::gray);
+        break;
+    case AimIcon:
+        pixmap.fill(Qt::yellow);
+        break;
+    case LeftShipIcon:
+    case UpperShipIcon:
+        pixmap = QPixmap(":/icons/left.png");
+        break;
+    case MiddleShipIcon:
+    case MiddleVerticalShipIcon:
+        pixmap = QPixmap(":/icons/middle.png");
+        break;
+    default:
+        pixmap = QPixmap(":/icons/right.png");
+        break;
+    }
 
-    upperShipIcon = QIcon(upperPixmap);
-    middleVerticalShipIcon = QIcon(middleVerticalPixmap);
-    lowerShipIcon = QIcon(lowerPixmap);
+    // Vertical ship pieces are the horizontal art turned a quarter
+    if (kind == UpperShipIcon || kind == MiddleVerticalShipIcon || kind == LowerShipIcon) {
+        QTransform transform;
+        transform.rotate(90);
+        pixmap = pixmap.transformed(transform);
+    }
+    return QIcon(pixmap);
 }
 
 void BattleshipGame::showStartupDialog() {
@@ -95,15 +112,24 @@ void BattleshipGame::showStartupDialog() {
     modeLayout->addWidget(singlePlayerButton);
     modeLayout->addWidget(multiplayerButton);
 
+    QLabel *rulesLabel = new QLabel("Rules:");
+    QComboBox *rulesComboBox = new QComboBox;
+    rulesComboBox->addItem("Classic (" + RuleSet::classic().describe() + ")");
+    rulesComboBox->addItem("Compact 7x7");
+
     QLabel *numShipsLabel = new QLabel("Number of Ships:");
     QSpinBox *numShipsSpinBox = new QSpinBox;
     numShipsSpinBox->setRange(1, 5); // Adjust the range as needed
     numShipsSpinBox->setValue(3);
+    numShipsLabel->hide();
+    numShipsSpinBox->hide();
 
     QPushButton *startButton = new QPushButton("Start Game");
 
     dialogLayout->addWidget(modeLabel);
     dialogLayout->addLayout(modeLayout);
+    dialogLayout->addWidget(rulesLabel);
+    dialogLayout->addWidget(rulesComboBox);
     dialogLayout->addWidget(numShipsLabel);
     dialogLayout->addWidget(numShipsSpinBox);
 
@@ -114,12 +140,15 @@ void BattleshipGame::showStartupDialog() {
     dialogLayout->addWidget(difficultyLabel);
     dialogLayout->addWidget(difficultyComboBox);
 
+    QCheckBox *salvoCheckBox = new QCheckBox("Salvo: one shot per ship afloat each turn");
+    dialogLayout->addWidget(salvoCheckBox);
+
     dialogLayout->addWidget(startButton);
 
     startupDialog->setLayout(dialogLayout);
 
     // Variables to store selections
-    numShips = 3; // Default value
+    rules = RuleSet::classic(); // Default value
     currentMode = SinglePlayer; // Default value
 
     // Indicate selection visually
@@ -133,6 +162,7 @@ void BattleshipGame::showStartupDialog() {
         multiplayerButton->setChecked(false);
         difficultyLabel->show();
         difficultyComboBox->show();
+        salvoCheckBox->show();
     });
 
     connect(multiplayerButton, &QPushButton::clicked, this, [&]() {
@@ -141,10 +171,18 @@ void BattleshipGame::showStartupDialog() {
         multiplayerButton->setChecked(true);
         difficultyLabel->hide();
         difficultyComboBox->hide();
+        salvoCheckBox->hide();
+    });
+
+    // Ship count only applies to the compact board; classic has a fixed fleet
+    connect(rulesComboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [&](int index) {
+        numShipsLabel->setVisible(index == 1);
+        numShipsSpinBox->setVisible(index == 1);
+        rules = index == 1 ? RuleSet::compact(numShipsSpinBox->value()) : RuleSet::classic();
     });
 
     connect(numShipsSpinBox, QOverload<int>::of(&QSpinBox::valueChanged), this, [&](int value) {
-        numShips = value;
+        rules = RuleSet::compact(value);
     });
 
     connect(difficultyComboBox, &QComboBox::currentTextChanged, this, [&](const QString &selectedDifficulty) {
@@ -152,6 +190,8 @@ void BattleshipGame::showStartupDialog() {
     });
 
     connect(startButton, &QPushButton::clicked, this, [&]() {
+        // Salvo is only wired up against the bot
+        rules.salvo = (currentMode == SinglePlayer && salvoCheckBox->isChecked()) ? SALVO_PER_SHIP : 0;
         startupDialog->accept();
     });
 
@@ -161,7 +201,9 @@ void BattleshipGame::showStartupDialog() {
         difficultyComboBox->hide();
     }
 
+    StartupProfile::mark("setup dialog");
     startupDialog->exec();
+    StartupProfile::mark("waiting for user", true);
 }
 
 void BattleshipGame::setupUI() {
@@ -175,9 +217,7 @@ void BattleshipGame::setupUI() {
 
     QLabel *shipLengthLabel = new QLabel("Select Ship Length:");
     shipLengthComboBox = new QComboBox;
-    for (int i = MIN_SHIP_SIZE; i <= MAX_SHIP_SIZE; ++i) {
-        shipLengthComboBox->addItem(QString::number(i));
-    }
+    refillShipLengths();
 
     topLayout->addWidget(shipLengthLabel);
     topLayout->addWidget(shipLengthComboBox);
@@ -266,6 +306,13 @@ void BattleshipGame::setupUI() {
     bottomLayout->addWidget(restartButton);
     bottomLayout->addWidget(exitButton);
 
+    // Latency panel is only useful when probes were switched on (--latency)
+    if (LatencyRecorder::isEnabled()) {
+        QPushButton *latencyButton = new QPushButton("Latency");
+        connect(latencyButton, &QPushButton::clicked, this, &BattleshipGame::showLatencyPanel);
+        bottomLayout->addWidget(latencyButton);
+    }
+
     mainLayout->addLayout(topLayout);
     mainLayout->addLayout(boardsLayout);
     mainLayout->addWidget(messageLabel);
@@ -276,13 +323,23 @@ void BattleshipGame::setupUI() {
     resize(900, 700);
 }
 
+// Ships still to be placed, one entry per ship of the fleet
+void BattleshipGame::refillShipLengths() {
+    shipLengthComboBox->clear();
+    for (int length : rules.shipLengths) {
+        shipLengthComboBox->addItem(QString::number(length));
+    }
+}
+
 void BattleshipGame::setupBoard(QGridLayout *gridLayout, bool isBotBoard) {
-    for (int row = 0; row < GRID_SIZE; ++row) {
-        for (int col = 0; col < GRID_SIZE; ++col) {
+    // Shrink the cells on bigger grids so both boards still fit the window
+    int cellSize = qMin(50, 400 / qMax(rules.rows, rules.cols));
+    for (int row = 0; row < rules.rows; ++row) {
+        for (int col = 0; col < rules.cols; ++col) {
             QPushButton *button = new QPushButton;
-            button->setFixedSize(50, 50);
-            button->setIcon(oceanIcon);
-            button->setIconSize(QSize(48, 48));
+            button->setFixedSize(cellSize, cellSize);
+            button->setIcon(icon(OceanIcon));
+            button->setIconSize(QSize(cellSize - 2, cellSize - 2));
 
             if (currentMode == SinglePlayer) {
                 if (isBotBoard) {
@@ -304,7 +361,7 @@ void BattleshipGame::setupBoard(QGridLayout *gridLayout, bool isBotBoard) {
                         if (gamePhase == PlacingShips && currentPlayer == 1) {
                             multiplayerPlaceShip(row, col, button);
                         } else if (gamePhase == Attacking && currentPlayer == 2) {
-                            multiplayerAttack(row, col, button);
+                            multiplayerAttack(row, col);
                         }
                     });
                 } else if (gridLayout == player2GridLayout) {
@@ -312,7 +369,7 @@ void BattleshipGame::setupBoard(QGridLayout *gridLayout, bool isBotBoard) {
                         if (gamePhase == PlacingShips && currentPlayer == 2) {
                             multiplayerPlaceShip(row, col, button);
                         } else if (gamePhase == Attacking && currentPlayer == 1) {
-                            multiplayerAttack(row, col, button);
+                            multiplayerAttack(row, col);
                         }
                     });
                 }
@@ -324,7 +381,8 @@ void BattleshipGame::setupBoard(QGridLayout *gridLayout, bool isBotBoard) {
 }
 
 void BattleshipGame::userPlaceShip(int row, int col, QPushButton *button) {
-    if (currentShip < numShips) {
+    TRACE_SPAN("ui", "userPlaceShip");
+    if (currentShip < rules.shipCount()) {
         int shipLength = shipLengthComboBox->currentText().toInt();
         bool isVertical = verticalRadio->isChecked();
         if (userBoard.isValidPosition(row, col, isVertical, shipLength)) {
@@ -337,29 +395,36 @@ void BattleshipGame::userPlaceShip(int row, int col, QPushButton *button) {
 
                 if(isVertical){
                     if(i == 0){
-                        shipButton -> setIcon(upperShipIcon);
+                        shipButton -> setIcon(icon(UpperShipIcon));
                     }else if(i == shipLength - 1){
-                        shipButton -> setIcon(lowerShipIcon);
+                        shipButton -> setIcon(icon(LowerShipIcon));
                     }else {
-                        shipButton->setIcon(middleVerticalShipIcon);
+                        shipButton->setIcon(icon(MiddleVerticalShipIcon));
                     }
                 }else{
 
                 if(i == 0){
-                    shipButton -> setIcon(leftShipIcon);
+                    shipButton -> setIcon(icon(LeftShipIcon));
                 }else if(i == shipLength - 1){
-                    shipButton -> setIcon(rightShipIcon);
+                    shipButton -> setIcon(icon(RightShipIcon));
                 }else {
-                    shipButton->setIcon(middleShipIcon);
+                    shipButton->setIcon(icon(MiddleShipIcon));
                 }}
                 shipButton->setIconSize(shipButton->size());
 
 
             }
             currentShip++;
-            if (currentShip == numShips) {
+            shipLengthComboBox->removeItem(shipLengthComboBox->currentIndex());
+            if (currentShip == rules.shipCount()) {
                 isPlacingShips = false;
-                messageLabel->setText("All ships placed! Attack the bot's ships.");
+                botPlaceShips();
+                if (rules.isSalvo()) {
+                    messageLabel->setText(QString("All ships placed! Pick %1 cells on the bot's board to fire a salvo.")
+                                              .arg(rules.shotsPerTurn(userBoard.shipsAfloat())));
+                } else {
+                    messageLabel->setText("All ships placed! Attack the bot's ships.");
+                }
             }
         } else {
             QMessageBox::warning(this, "Invalid Position", "You cannot place a ship here.");
@@ -368,223 +433,192 @@ void BattleshipGame::userPlaceShip(int row, int col, QPushButton *button) {
 }
 
 void BattleshipGame::userAttack(int row, int col, QPushButton *button) {
+    TRACE_SPAN("ui", "userAttack");
+    if (rules.isSalvo()) {
+        aimSalvoShot(row, col, button);
+        return;
+    }
     if (botBoard.getCell(row, col) == 'X' || botBoard.getCell(row, col) == 'O') {
         QMessageBox::warning(this, "Invalid Move", "You have already attacked this position.");
         return;
     }
 
-    if (botBoard.attack(row, col)) {
-        button->setIcon(hitIcon);
-        messageLabel->setText("Hit!");
-        if (!botBoard.hasShipsRemaining()) {
-            gameOver = true;
-            messageLabel->setText("You win! All bot's ships are sunk!");
-        } else {
-            botAttack();
-        }
+    userShots.append(row * rules.cols + col);
+    events.shot(0, botBoard, row, col, botBoard.attack(row, col));
+    if (!botBoard.hasShipsRemaining()) {
+        gameOver = true;
+        recordOpponentProfile();
+        events.gameOver(0);
     } else {
-        button->setIcon(missIcon);
-        messageLabel->setText("Miss!");
         botAttack();
     }
+    showEvents();
 }
 
 void BattleshipGame::botAttack() {
     if (!gameOver) {
-        if (difficulty == "Easy") {
-            botEasyAttack();
-        } else if (difficulty == "Medium") {
-            botMediumAttack();
-        } else if (difficulty == "Hard") {
-            botHardAttack();
-        } else if (difficulty == "Expert") {
-            botAttackExpertMode();
-        }
+        BotShot shot = bot.attack(userBoard);
+        if (shot.row >= 0) events.shot(1, userBoard, shot.row, shot.col, shot.hit);
         if (!userBoard.hasShipsRemaining()) {
             gameOver = true;
-            messageLabel->setText("Bot wins! All your ships are sunk!");
+            recordOpponentProfile();
+            events.gameOver(1);
         }
     }
 }
 
-void BattleshipGame::botEasyAttack() {
-    int row, col;
-    do {
-        row = rand() % GRID_SIZE;
-        col = rand() % GRID_SIZE;
-    } while (userBoard.getCell(row, col) == 'X' || userBoard.getCell(row, col) == 'O');
+// Salvo rules: clicks toggle aimed cells; the salvo fires once enough are aimed.
+void BattleshipGame::aimSalvoShot(int row, int col, QPushButton *button) {
+    if (botBoard.getCell(row, col) == 'X' || botBoard.getCell(row, col) == 'O') {
+        QMessageBox::warning(this, "Invalid Move", "You have already attacked this position.");
+        return;
+    }
 
-    QPushButton *button = findButtonAt(row, col, userGridLayout);
-    if (userBoard.attack(row, col)) {
-        button->setIcon(hitIcon);
+    int cell = row * rules.cols + col;
+    if (pendingSalvo.test(cell)) {
+        pendingSalvo.reset(cell);
+        button->setIcon(icon(OceanIcon));
     } else {
-        button->setIcon(missIcon);
+        pendingSalvo.set(cell);
+        button->setIcon(icon(AimIcon));
     }
-}
 
-void BattleshipGame::botMediumAttack() {
-    if (botTargets.isEmpty()) {
-        botEasyAttack();
-    } else {
-        int index = rand() % botTargets.size();
-        QPair<int, int> target = botTargets[index];
-        QPushButton *button = findButtonAt(target.first, target.second, userGridLayout);
-        if (userBoard.attack(target.first, target.second)) {
-            button->setIcon(hitIcon);
-            lastHit = target;
-            botTargets.removeAt(index);
-        } else {
-            button->setIcon(missIcon);
-            botTargets.removeAt(index);
-        }
+    int shots = qMin(rules.shotsPerTurn(userBoard.shipsAfloat()), botBoard.untriedMask().count());
+    if (pendingSalvo.count() < shots) {
+        messageLabel->setText(QString("Salvo: %1 of %2 shots aimed.").arg(pendingSalvo.count()).arg(shots));
+        return;
     }
+    userSalvo();
 }
 
-void BattleshipGame::botSmartAttack() {
-    if (gameOver) return;
-
-    int botRow = -1, botCol = -1;
-    bool hit = false;
+// Both salvos of a turn are resolved with updates off, so the window repaints once.
+void BattleshipGame::userSalvo() {
+    TRACE_SPAN("ui", "userSalvo");
+    centralWidget->setUpdatesEnabled(false);
 
-    // Select target position
-    if (huntingMode && !possibleMoves.isEmpty()) {
-        // Continue hunting in the vicinity of the last hit
-        QPair<int, int> target = possibleMoves.takeFirst();
-        botRow = target.first;
-        botCol = target.second;
-    } else {
-        // Search for a new target
-        huntingMode = false; // Ensure hunting mode is off when starting a new search
-        possibleMoves.clear(); // Clear any leftover moves
-        do {
-            botRow = rand() % GRID_SIZE;
-            botCol = rand() % GRID_SIZE;
-        } while (userBoard.getCell(botRow,botCol) == 'X' || userBoard.getCell(botRow,botCol) == 'O');
+    SalvoResult salvo = botBoard.attackBatch(pendingSalvo);
+    pendingSalvo = CellMask();
+    for (int cell = 0; cell < rules.cells(); ++cell) {
+        if (salvo.shots.test(cell)) userShots.append(cell);
     }
-
-    hit = userBoard.attack(botRow, botCol);
-    QPushButton* button = findButtonAt(botRow, botCol, userGridLayout);
-
-    if (hit) {
-        button->setIcon(hitIcon);
-        messageLabel->setText(QString("Bot hits at %1%2!").arg(QChar('A' + botCol)).arg(botRow + 1));
-        addAdjacentPositions(botRow, botCol);
-        huntingMode = true;
+    events.salvo(0, botBoard, salvo);
+    if (!botBoard.hasShipsRemaining()) {
+        gameOver = true;
+        recordOpponentProfile();
+        events.gameOver(0);
     } else {
-        button->setIcon(missIcon);
-        messageLabel->setText(QString("Bot misses at %1%2.").arg(QChar('A' + botCol)).arg(botRow + 1));
+        botSalvo();
     }
+    showEvents();
 
-    if (!userBoard.hasShipsRemaining()) {
-        gameOver = true;
-        messageLabel->setText("Bot wins! Game over.");
-    }
+    centralWidget->setUpdatesEnabled(true);
 }
 
-bool BattleshipGame::isPositionInPossibleMoves(int row, int col) {
-    for (const auto& pos : possibleMoves) {
-        if (pos.first == row && pos.second == col) {
-            return true;
-        }
+void BattleshipGame::botSalvo() {
+    if (gameOver) return;
+    SalvoResult salvo = bot.attackSalvo(userBoard, rules.shotsPerTurn(botBoard.shipsAfloat()));
+    events.salvo(1, userBoard, salvo);
+    if (!userBoard.hasShipsRemaining()) {
+        gameOver = true;
+        recordOpponentProfile();
+        events.gameOver(1);
     }
-    return false;
 }
 
-void BattleshipGame::addAdjacentPositions(int row, int col) {
-    QVector<QPair<int, int>> adjDirections = {
-        qMakePair(-1, 0), // Up
-        qMakePair(1, 0),  // Down
-        qMakePair(0, -1), // Left
-        qMakePair(0, 1)   // Right
-    };
-
-    for (const auto& dir : adjDirections) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
-        if (isValidCell(newRow, newCol)) {
-            // Check if the position has not been attacked and is not already in possibleMoves
-            if (userBoard.getCell(newRow,newCol) != 'X' && userBoard.getCell(newRow,newCol) != 'O' &&
-                !isPositionInPossibleMoves(newRow, newCol)) {
-                possibleMoves.append(qMakePair(newRow, newCol));
+// The UI's side of the event stream: the game code only publishes events,
+// and the boards and message line catch up with them here. Salvo turns are
+// summed up from their shots once the queue is drained.
+void BattleshipGame::showEvents() {
+    int salvoShots[2] = {0, 0};
+    int salvoHits[2] = {0, 0};
+    int salvoSunk[2] = {0, 0};
+    bool finished = false;
+    GameEvent event;
+    while (events.poll(uiEvents, event)) {
+        switch (event.type) {
+        case GameEvent::ShotFired:
+            salvoShots[event.player]++;
+            break;
+        case GameEvent::Sunk:
+            salvoSunk[event.player]++;
+            break;
+        case GameEvent::Hit:
+        case GameEvent::Miss: {
+            bool hit = event.type == GameEvent::Hit;
+            QPushButton *button = findButtonAt(event.row, event.col, targetLayout(event.player));
+            if (button) button->setIcon(icon(hit ? HitIcon : MissIcon));
+            if (hit) salvoHits[event.player]++;
+            if (rules.isSalvo()) break;
+            QString cell = QString("%1%2").arg(QChar('A' + event.col)).arg(event.row + 1);
+            if (currentMode == Multiplayer) {
+                messageLabel->setText(hit ? QString("Player %1 hit a ship!").arg(event.player + 1)
+                                          : QString("Player %1 missed.").arg(event.player + 1));
+            } else if (event.player == 0) {
+                messageLabel->setText(hit ? "Hit!" : "Miss!");
+            } else {
+                messageLabel->setText(messageLabel->text() +
+                                      (hit ? " Bot hits at " + cell + "!" : " Bot misses at " + cell + "."));
             }
+            break;
         }
-    }
-}
-bool BattleshipGame::isValidCell(int row, int col) {
-    return row >= 0 && row < GRID_SIZE && col >= 0 && col < GRID_SIZE;
-}
-
-void BattleshipGame::botHardAttack() {
-    if (gameOver) return;
-
-    if (!lastHits.isEmpty()) {
-        // Continue attacking in the current direction
-        QPair<int, int> lastHit = lastHits.last();
-        int newRow = lastHit.first + directions[currentDirection].first;
-        int newCol = lastHit.second + directions[currentDirection].second;
-
-        if (isValidCell(newRow, newCol)) {
-            if (userBoard.getCell(newRow,newCol) != 'X' && userBoard.getCell(newRow,newCol) != 'O') {
-                QPushButton *button = findButtonAt(newRow, newCol, userGridLayout);
-                if (userBoard.attack(newRow, newCol)) {
-                    button->setIcon(hitIcon);
-                    lastHits.append({newRow, newCol});
-                    messageLabel->setText("Bot hit your ship!");
-                    if (!userBoard.hasShipsRemaining()) {
-                        gameOver = true;
-                        messageLabel->setText("Bot wins! Game over.");
-                    }
-                } else {
-                    button->setIcon(missIcon);
-                    messageLabel->setText("Bot missed!");
-                    // Change direction after a miss
-                    currentDirection = (currentDirection + 1) % 4;
-                }
-                return;
+        case GameEvent::TurnChanged: {
+            messageLabel->setText(QString("Player %1's turn to attack.").arg(event.player + 1));
+
+            // Hide the mover's own board and show the one they attack
+            QGridLayout *currentGridLayout = targetLayout(event.player);
+            QGridLayout *previousGridLayout = targetLayout(1 - event.player);
+            for (int i = 0; i < previousGridLayout->count(); ++i) {
+                QWidget *widget = previousGridLayout->itemAt(i)->widget();
+                if (widget)
+                    widget->hide();
+            }
+            for (int i = 0; i < currentGridLayout->count(); ++i) {
+                QWidget *widget = currentGridLayout->itemAt(i)->widget();
+                if (widget)
+                    widget->show();
             }
+            break;
         }
-
-        // If the current direction is invalid, try the next direction
-        currentDirection = (currentDirection + 1) % 4;
-        if (currentDirection == 0) {
-            // If we've tried all directions, start from the first hit in a new direction
-            lastHits.pop_back();
-            if (!lastHits.isEmpty()) {
-                botHardAttack();
+        case GameEvent::GameOver:
+            finished = true;
+            if (currentMode == Multiplayer) {
+                messageLabel->setText(QString("Player %1 wins! All opponent's ships are sunk!").arg(event.player + 1));
             } else {
-                // If no more hits to work from, make a random attack
-                do {
-                    int row = rand() % GRID_SIZE;
-                    int col = rand() % GRID_SIZE;
-                    if (userBoard.getCell(row,col) != 'X' && userBoard.getCell(row,col) != 'O') {
-                        QPushButton *button = findButtonAt(row, col, userGridLayout);
-                        if (userBoard.attack(row, col)) {
-                            button->setIcon(hitIcon);
-                            lastHits.append({row, col});
-                            currentDirection = 0;
-                            messageLabel->setText("Bot hit your ship!");
-                        } else {
-                            button->setIcon(missIcon);
-                            messageLabel->setText("Bot missed!");
-                        }
-                        break;
-                    }
-                } while (true);
+                messageLabel->setText(event.player == 0 ? "You win! All bot's ships are sunk!"
+                                                        : "Bot wins! All your ships are sunk!");
             }
-        } else {
-            botHardAttack();
+            break;
+        default:
+            break;
         }
-    } else {
-        // If no recent hits, use the medium difficulty strategy
-        botSmartAttack();
     }
+
+    if (!rules.isSalvo() || finished) return;
+    QStringList summary;
+    for (int player = 0; player < 2; ++player) {
+        if (salvoShots[player] == 0) continue;
+        QString who = currentMode == Multiplayer ? QString("Player %1's").arg(player + 1)
+                      : player == 0 ? QString("Your") : QString("Bot");
+        QString line = QString("%1 salvo: %2 of %3 hit").arg(who).arg(salvoHits[player]).arg(salvoShots[player]);
+        if (salvoSunk[player] > 0) line += QString(", %1 sunk").arg(salvoSunk[player]);
+        summary.append(line + ".");
+    }
+    if (!summary.isEmpty()) messageLabel->setText(summary.join(" "));
 }
+
+// Board the side fires at: the bot's (or player 2's) for side 0
+QGridLayout *BattleshipGame::targetLayout(int player) const {
+    if (currentMode == Multiplayer) return player == 0 ? player2GridLayout : player1GridLayout;
+    return player == 0 ? botGridLayout : userGridLayout;
+}
+
 void BattleshipGame::multiplayerPlaceShip(int row, int col, QPushButton *button) {
+    TRACE_SPAN("ui", "multiplayerPlaceShip");
     Board &currentBoard = (currentPlayer == 1) ? player1Board : player2Board;
     QGridLayout *currentGridLayout = (currentPlayer == 1) ? player1GridLayout : player2GridLayout;
     int &currentShip = (currentPlayer == 1) ? currentShipPlayer1 : currentShipPlayer2;
 
-    if (currentShip < numShips) {
+    if (currentShip < rules.shipCount()) {
         int shipLength = shipLengthComboBox->currentText().toInt();
         bool isVertical = verticalRadio->isChecked();
         if (currentBoard.isValidPosition(row, col, isVertical, shipLength)) {
@@ -593,13 +627,15 @@ void BattleshipGame::multiplayerPlaceShip(int row, int col, QPushButton *button)
                 QPushButton *shipButton = isVertical ?
                                               findButtonAt(row + i, col, currentGridLayout) :
                                               findButtonAt(row, col + i, currentGridLayout);
-                shipButton->setIcon(shipIcon);
+                shipButton->setIcon(icon(ShipIcon));
             }
             currentShip++;
-            if (currentShip == numShips) {
+            shipLengthComboBox->removeItem(shipLengthComboBox->currentIndex());
+            if (currentShip == rules.shipCount()) {
                 if (currentPlayer == 1) {
                     // Switch to Player 2
                     currentPlayer = 2;
+                    refillShipLengths();
                     messageLabel->setText("Player 2: Place your ships on your board.");
 
                     // Hide Player 1's board and show Player 2's board
@@ -622,13 +658,13 @@ void BattleshipGame::multiplayerPlaceShip(int row, int col, QPushButton *button)
                     // Hide all ships on both boards
                     for (int i = 0; i < player1GridLayout->count(); ++i) {
                         QPushButton *btn = qobject_cast<QPushButton *>(player1GridLayout->itemAt(i)->widget());
-                        if (btn && btn->icon().cacheKey() == shipIcon.cacheKey())
-                            btn->setIcon(oceanIcon);
+                        if (btn && btn->icon().cacheKey() == icon(ShipIcon).cacheKey())
+                            btn->setIcon(icon(OceanIcon));
                     }
                     for (int i = 0; i < player2GridLayout->count(); ++i) {
                         QPushButton *btn = qobject_cast<QPushButton *>(player2GridLayout->itemAt(i)->widget());
-                        if (btn && btn->icon().cacheKey() == shipIcon.cacheKey())
-                            btn->setIcon(oceanIcon);
+                        if (btn && btn->icon().cacheKey() == icon(ShipIcon).cacheKey())
+                            btn->setIcon(icon(OceanIcon));
                     }
 
                     // Show opponent's board
@@ -650,47 +686,43 @@ void BattleshipGame::multiplayerPlaceShip(int row, int col, QPushButton *button)
     }
 }
 
-void BattleshipGame::multiplayerAttack(int row, int col, QPushButton *button) {
+void BattleshipGame::multiplayerAttack(int row, int col) {
+    TRACE_SPAN("ui", "multiplayerAttack");
     Board &opponentBoard = (currentPlayer == 1) ? player2Board : player1Board;
-    QGridLayout *opponentGridLayout = (currentPlayer == 1) ? player2GridLayout : player1GridLayout;
 
     if (opponentBoard.getCell(row,col) == 'X' || opponentBoard.getCell(row,col) == 'O') {
         QMessageBox::warning(this, "Invalid Move", "You have already attacked this position.");
         return;
     }
 
-    if (opponentBoard.attack(row, col)) {
-        button->setIcon(hitIcon);
-        messageLabel->setText(QString("Player %1 hit a ship!").arg(currentPlayer));
-        if (!opponentBoard.hasShipsRemaining()) {
-            messageLabel->setText(QString("Player %1 wins! All opponent's ships are sunk!").arg(currentPlayer));
-            gamePhase = PlacingShips; // End the game
-        }
-    } else {
-        button->setIcon(missIcon);
-        messageLabel->setText(QString("Player %1 missed.").arg(currentPlayer));
+    events.shot(currentPlayer - 1, opponentBoard, row, col, opponentBoard.attack(row, col));
+    if (!opponentBoard.hasShipsRemaining()) {
+        events.gameOver(currentPlayer - 1);
+        gamePhase = PlacingShips; // End the game
     }
 
     // Switch turns
     currentPlayer = (currentPlayer == 1) ? 2 : 1;
-    if (gamePhase != PlacingShips) {
-        messageLabel->setText(QString("Player %1's turn to attack.").arg(currentPlayer));
-
-        // Hide current board and show opponent's board
-        QGridLayout *currentGridLayout = (currentPlayer == 1) ? player2GridLayout : player1GridLayout;
-        QGridLayout *previousGridLayout = (currentPlayer == 1) ? player1GridLayout : player2GridLayout;
+    if (gamePhase != PlacingShips) events.turnChanged(currentPlayer - 1);
+    showEvents();
+}
 
-        for (int i = 0; i < previousGridLayout->count(); ++i) {
-            QWidget *widget = previousGridLayout->itemAt(i)->widget();
-            if (widget)
-                widget->hide();
-        }
-        for (int i = 0; i < currentGridLayout->count(); ++i) {
-            QWidget *widget = currentGridLayout->itemAt(i)->widget();
-            if (widget)
-                widget->show();
+// Qt repaints the whole window (both board views included) while handling
+// UpdateRequest, so one span here covers the paint after each click.
+bool BattleshipGame::event(QEvent *event) {
+    if (event->type() == QEvent::Paint && !firstPaintSeen) {
+        firstPaintSeen = true;
+        // Report once this paint has gone out, not when it starts
+        if (StartupProfile::isEnabled()) {
+            QTimer::singleShot(0, this, []() {
+                StartupProfile::mark("first paint");
+                qInfo("%s", qPrintable(StartupProfile::report()));
+            });
         }
     }
+    if (event->type() != QEvent::UpdateRequest) return QMainWindow::event(event);
+    TRACE_SPAN("paint", "repaint");
+    return QMainWindow::event(event);
 }
 
 QPushButton *BattleshipGame::findButtonAt(int row, int col, QGridLayout *layout) {
@@ -703,24 +735,32 @@ QPushButton *BattleshipGame::findButtonAt(int row, int col, QGridLayout *layout)
 
 void BattleshipGame::onDifficultyChanged(const QString &selectedDifficulty) {
     difficulty = selectedDifficulty;
+    bot = BotPlayer(BotPlayer::difficultyFromName(difficulty));
     resetGame();
     messageLabel->setText("Difficulty changed to " + difficulty + ". Place your ships.");
 }
 
 void BattleshipGame::resetGame() {
-    userBoard = Board(numShips);
-    botBoard = Board(numShips);
-    player1Board = Board(numShips);
-    player2Board = Board(numShips);
+    // Only the boards this mode plays on, as in the constructor
+    if (currentMode == SinglePlayer) {
+        userBoard = Board(rules);
+        botBoard = Board(rules);
+    } else {
+        player1Board = Board(rules);
+        player2Board = Board(rules);
+    }
+    refillShipLengths();
+    pendingSalvo = CellMask();
+    userShots.clear();
     currentShip = 0;
     isPlacingShips = true;
     gameOver = false;
-    botTargets.clear();
-    lastHit = qMakePair(-1, -1);
+    bot.reset();
     currentShipPlayer1 = 0;
     currentShipPlayer2 = 0;
     currentPlayer = 1;
     gamePhase = PlacingShips;
+    events.newGame();
 
     if (currentMode == SinglePlayer) {
         // Clear the grids
@@ -728,7 +768,7 @@ void BattleshipGame::resetGame() {
             for (int j = 0; j < userGridLayout->columnCount(); ++j) {
                 QPushButton *button = findButtonAt(i, j, userGridLayout);
                 if (button) {
-                    button->setIcon(oceanIcon);
+                    button->setIcon(icon(OceanIcon));
                 }
             }
         }
@@ -737,13 +777,12 @@ void BattleshipGame::resetGame() {
             for (int j = 0; j < botGridLayout->columnCount(); ++j) {
                 QPushButton *button = findButtonAt(i, j, botGridLayout);
                 if (button) {
-                    button->setIcon(oceanIcon);
+                    button->setIcon(icon(OceanIcon));
                 }
             }
         }
 
         messageLabel->setText("Place your ships on your board.");
-        botPlaceShips();
     } else {
         // Multiplayer reset
         // Clear the grids
@@ -751,7 +790,7 @@ void BattleshipGame::resetGame() {
             for (int j = 0; j < player1GridLayout->columnCount(); ++j) {
                 QPushButton *button = findButtonAt(i, j, player1GridLayout);
                 if (button) {
-                    button->setIcon(oceanIcon);
+                    button->setIcon(icon(OceanIcon));
                     button->show();
                 }
             }
@@ -761,7 +800,7 @@ void BattleshipGame::resetGame() {
             for (int j = 0; j < player2GridLayout->columnCount(); ++j) {
                 QPushButton *button = findButtonAt(i, j, player2GridLayout);
                 if (button) {
-                    button->setIcon(oceanIcon);
+                    button->setIcon(icon(OceanIcon));
                     button->hide();
                 }
             }
@@ -771,133 +810,55 @@ void BattleshipGame::resetGame() {
     }
 }
 
+// Called once the user's fleet is down. The profile is read here rather than
+// at startup, and must be loaded before recordOpponentProfile() saves it.
 void BattleshipGame::botPlaceShips() {
-    for (int i = 0; i < numShips; i++) {
-        int shipLength = MIN_SHIP_SIZE + (rand() % (MAX_SHIP_SIZE - MIN_SHIP_SIZE + 1));
-        bool isVertical = rand() % 2;
-        int row, col;
-        do {
-            row = rand() % GRID_SIZE;
-            col = rand() % GRID_SIZE;
-        } while (!botBoard.isValidPosition(row, col, isVertical, shipLength));
-        botBoard.placeShip(row, col, isVertical, shipLength);
+    if (!profileLoaded) {
+        opponentProfile = OpponentProfile(rules.rows, rules.cols);
+        opponentProfile.load(profilePath());
+        profileLoaded = true;
     }
+    bot.setOpponentProfile(opponentProfile, rules);
+    bot.placeFleet(botBoard, rules);
 }
 
-void BattleshipGame::botAttackExpertMode() {
-    if (gameOver) return;
-
-    if (botTargets.isEmpty()) {
-        // Randomly attack until a ship is hit
-        int row, col;
-        do {
-            row = rand() % GRID_SIZE;
-            col = rand() % GRID_SIZE;
-        } while (userBoard.getCell(row, col) == 'X' || userBoard.getCell(row, col) == 'O');
-
-        QPushButton *button = findButtonAt(row, col, userGridLayout);
-        if (userBoard.attack(row, col)) {
-            button->setIcon(hitIcon);
-            lastHit = qMakePair(row, col);
-            initializeProbabilityVector(row, col);
-            identifyAndQueuePossibleTargets(row, col);
-        } else {
-            button->setIcon(missIcon);
-        }
-    } else {
-        // Use the priority queue to make strategic attacks
-        while (!botTargets.isEmpty()) {
-            auto target = botTargets.back();
-            botTargets.pop_back();
-            int row = target.first;
-            int col = target.second;
-
-            if (userBoard.getCell(row, col) != 'X' && userBoard.getCell(row, col) != 'O') {
-                QPushButton *button = findButtonAt(row, col, userGridLayout);
-                if (userBoard.attack(row, col)) {
-                    button->setIcon(hitIcon);
-                    lastHit = qMakePair(row, col);
-                    updateProbabilityVector(row, col);
-                    identifyAndQueuePossibleTargets(row, col);
-
-                    if (isShipSunk(row, col)) {
-                        resetSearchForNextShip();
-                        break;
-                    }
-                } else {
-                    button->setIcon(missIcon);
-                }
-                break;
-            }
-        }
-    }
+// One profile per grid shape; the histograms are per cell
+QString BattleshipGame::profilePath() const {
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(dir);
+    return dir + QString("/opponent-%1x%2.profile").arg(rules.rows).arg(rules.cols);
 }
 
-void BattleshipGame::initializeProbabilityVector(int row, int col) {
-    probabilityVector.clear();
-    QVector<QPair<int, int>> directions = {
-        qMakePair(-1, 0), qMakePair(1, 0), qMakePair(0, -1), qMakePair(0, 1)
-    };
-    for (const auto &dir : directions) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
-        if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE) {
-            probabilityVector.push_back(qMakePair(newRow, newCol));
-        }
-    }
-}
-
-void BattleshipGame::identifyAndQueuePossibleTargets(int row, int col) {
-    QVector<QPair<int, int>> newTargets;
-    QVector<QPair<int, int>> directions = {
-        qMakePair(-1, 0), qMakePair(1, 0), qMakePair(0, -1), qMakePair(0, 1)
-    };
-
-    for (const auto &dir : directions) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
-        if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE &&
-            userBoard.getCell(newRow, newCol) != 'X' && userBoard.getCell(newRow, newCol) != 'O') {
-            newTargets.append(qMakePair(newRow, newCol));
-        }
-    }
-
-    for (const auto &target : newTargets) {
-        botTargets.push_front(target);
-    }
+// Single-player game over: fold the user's fleet and shots into their profile.
+// The bot picks it up from the next game on.
+void BattleshipGame::recordOpponentProfile() {
+    opponentProfile.recordGame(userBoard, userShots);
+    opponentProfile.save(profilePath());
 }
 
-void BattleshipGame::updateProbabilityVector(int row, int col) {
-    QVector<QPair<int, int>> additionalTargets;
-    QVector<QPair<int, int>> directions = {
-        qMakePair(-1, 0), qMakePair(1, 0), qMakePair(0, -1), qMakePair(0, 1)
-    };
-    for (const auto &dir : directions) {
-        int newRow = row + dir.first;
-        int newCol = col + dir.second;
-        if (newRow >= 0 && newRow < GRID_SIZE && newCol >= 0 && newCol < GRID_SIZE &&
-            userBoard.getCell(newRow, newCol) != 'X' && userBoard.getCell(newRow, newCol) != 'O') {
-            additionalTargets.push_back(qMakePair(newRow, newCol));
-        }
-    }
+void BattleshipGame::showLatencyPanel() {
+    QDialog *panel = new QDialog(this);
+    panel->setAttribute(Qt::WA_DeleteOnClose);
+    panel->setWindowTitle("Bot Latency");
+    QVBoxLayout *layout = new QVBoxLayout;
 
-    for (const auto &target : additionalTargets) {
-        if (!botTargets.contains(target)) {
+    QPlainTextEdit *report = new QPlainTextEdit;
+    report->setReadOnly(true);
+    report->setFont(QFont("Monospace"));
+    report->setPlainText(LatencyRecorder::local().toText());
 
-            botTargets.push_front(target);
-        }
-    }
-}
+    QPushButton *refreshButton = new QPushButton("Refresh");
+    connect(refreshButton, &QPushButton::clicked, panel, [report]() {
+        report->setPlainText(LatencyRecorder::local().toText());
+    });
 
-bool BattleshipGame::isShipSunk(int row, int col) {
-    return !userBoard.hasShipsRemaining();
+    layout->addWidget(report);
+    layout->addWidget(refreshButton);
+    panel->setLayout(layout);
+    panel->resize(560, 300);
+    panel->show();
 }
 
-void BattleshipGame::resetSearchForNextShip() {
-    probabilityVector.clear();
-    botTargets.clear();
-    lastHit = qMakePair(-1, -1);
-}
 void BattleshipGame::onRestartClicked() {
     resetGame();
 }
@@ -11,8 +11,9 @@
 #include <QVector>
 #include <QIcon>
 #include "Board.h"
-
-enum AttackDirection { UNKNOWN, HORIZONTAL, VERTICAL };
+#include "botplayer.h"
+#include "gameevents.h"
+#include "opponentprofile.h"
 
 class BattleshipGame : public QMainWindow {
     Q_OBJECT
@@ -20,12 +21,15 @@ class BattleshipGame : public QMainWindow {
 public:
     explicit BattleshipGame(QWidget *parent = nullptr);
 
+protected:
+    bool event(QEvent *event) override;
+
 private:
     enum GameMode { SinglePlayer, Multiplayer };
     GameMode currentMode;
 
     // Single-player variables
-    int numShips;
+    RuleSet rules;
     Board userBoard;
     Board botBoard;
     int currentShip;
@@ -33,13 +37,13 @@ private:
     bool gameOver;
     QString message;
     QString difficulty;
-    QVector<QPair<int, int>> botTargets;
-    QPair<int, int> lastHit;
+    BotPlayer bot;
     QComboBox *shipLengthComboBox;
-    bool huntingMode;
-    QVector<QPair<int, int>> possibleMoves;
-    QVector<QPair<int, int>> probabilityVector;
-     AttackDirection attackDirection = UNKNOWN;
+    CellMask pendingSalvo; // cells aimed at but not yet fired (salvo rules)
+    OpponentProfile opponentProfile; // the human's habits, kept across sessions
+    QVector<int> userShots; // cells the user fired at this game, in order
+    GameEventStream events; // shots, turns and results, for showEvents() and any other watcher
+    int uiEvents; // showEvents()'s subscription
 
     // Multiplayer variables
     enum GamePhase { PlacingShips, Attacking };
@@ -63,53 +67,43 @@ private:
     QPushButton *restartButton;
     QPushButton *exitButton;
 
-    QIcon shipIcon;
-    QIcon hitIcon;
-    QIcon missIcon;
-    QIcon oceanIcon;
-    QIcon leftShipIcon;
-    QIcon rightShipIcon;
-    QIcon middleShipIcon;
-
-    QIcon upperShipIcon;
-    QIcon middleVerticalShipIcon;
-    QIcon lowerShipIcon;
+    // Icons are drawn the first time a cell needs them
+    enum GameIcon {
+        OceanIcon, ShipIcon, HitIcon, MissIcon, AimIcon,
+        LeftShipIcon, MiddleShipIcon, RightShipIcon,
+        UpperShipIcon, MiddleVerticalShipIcon, LowerShipIcon,
+        ICON_COUNT
+    };
+    QIcon icons[ICON_COUNT];
+    bool profileLoaded;
+    bool firstPaintSeen;
 
     // Private functions
-    void createIcons();
+    const QIcon &icon(GameIcon kind);
+    static QIcon createIcon(GameIcon kind);
     void setupUI();
     void setupBoard(QGridLayout *gridLayout, bool isBotBoard = false);
     void userPlaceShip(int row, int col, QPushButton *button);
     void userAttack(int row, int col, QPushButton *button);
     void botAttack();
-    void botEasyAttack();
-    void botMediumAttack();
-    void botHardAttack();
+    void aimSalvoShot(int row, int col, QPushButton *button);
+    void userSalvo();
+    void botSalvo();
+    void showEvents();
+    QGridLayout *targetLayout(int player) const;
     QPushButton *findButtonAt(int row, int col, QGridLayout *layout);
     void resetGame();
     void botPlaceShips();
     void showStartupDialog();
-    void botAttackExpertMode();
-    void initializeProbabilityVector(int row, int col);
-    void identifyAndQueuePossibleTargets(int row, int col);
-    void updateProbabilityVector(int row, int col);
-    bool isShipSunk(int row, int col);
-    void resetSearchForNextShip();
-    void determineAttackDirection(int row, int col);
-    void queueLineTargets(int row, int col);
-        void botSmartAttack();
-    void addAdjacentPositions(int row, int col);
-    bool isPositionInPossibleMoves(int row, int col);
-    QVector<QPair<int, int>> lastHits;
-
-    bool isValidCell(int row, int col);
-    QVector<QPair<int, int>> directions{{0, 1}, {1, 0}, {0, -1}, {-1, 0}};
-    int currentDirection;
+    void refillShipLengths();
+    void showLatencyPanel();
+    QString profilePath() const;
+    void recordOpponentProfile();
 
 
     // Multiplayer functions
     void multiplayerPlaceShip(int row, int col, QPushButton *button);
-    void multiplayerAttack(int row, int col, QPushButton *button);
+    void multiplayerAttack(int row, int col);
     void switchTurns();
 
 private slots:
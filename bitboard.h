@@ -0,0 +1,120 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+
+// Fixed-size set of cells, one bit per cell (row * columns + col).
+template <int Bits>
+class BitMask {
+public:
+    enum { WORDS = (Bits + 63) / 64 };
+
+    BitMask() {
+        for (int i = 0; i < WORDS; ++i) words[i] = 0;
+    }
+
+    static BitMask full() {
+        BitMask mask;
+        for (int i = 0; i < WORDS; ++i) mask.words[i] = ~quint64(0);
+        mask.trim();
+        return mask;
+    }
+
+    // Bits 0 .. count - 1 set.
+    static BitMask firstBits(int count) {
+        BitMask mask;
+        for (int i = 0; i < WORDS; ++i) {
+            int inWord = qBound(0, count - i * 64, 64);
+            mask.words[i] = inWord == 64 ? ~quint64(0) : (quint64(1) << inWord) - 1;
+        }
+        return mask;
+    }
+
+    void set(int bit) { words[bit >> 6] |= quint64(1) << (bit & 63); }
+    void reset(int bit) { words[bit >> 6] &= ~(quint64(1) << (bit & 63)); }
+    bool test(int bit) const { return (words[bit >> 6] >> (bit & 63)) & 1; }
+
+    int count() const {
+        int total = 0;
+        for (int i = 0; i < WORDS; ++i) total += qPopulationCount(words[i]);
+        return total;
+    }
+
+    bool isEmpty() const {
+        for (int i = 0; i < WORDS; ++i) {
+            if (words[i]) return false;
+        }
+        return true;
+    }
+
+    // Index of the n-th set bit (0-based), or -1 if there are not that many.
+    int select(int n) const {
+        for (int i = 0; i < WORDS; ++i) {
+            int inWord = qPopulationCount(words[i]);
+            if (n < inWord) {
+                quint64 word = words[i];
+                while (n-- > 0) word &= word - 1;
+                return i * 64 + qCountTrailingZeroBits(word);
+            }
+            n -= inWord;
+        }
+        return -1;
+    }
+
+    BitMask &operator&=(const BitMask &other) {
+        for (int i = 0; i < WORDS; ++i) words[i] &= other.words[i];
+        return *this;
+    }
+    BitMask &operator|=(const BitMask &other) {
+        for (int i = 0; i < WORDS; ++i) words[i] |= other.words[i];
+        return *this;
+    }
+    BitMask operator&(const BitMask &other) const { BitMask r = *this; r &= other; return r; }
+    BitMask operator|(const BitMask &other) const { BitMask r = *this; r |= other; return r; }
+    // Shifted towards higher (<<) or lower (>>) bit numbers; bits shifted past
+    // either end are dropped.
+    BitMask operator<<(int shift) const {
+        BitMask r;
+        int wordShift = shift >> 6, bitShift = shift & 63;
+        for (int i = WORDS - 1; i >= wordShift; --i) {
+            quint64 word = words[i - wordShift] << bitShift;
+            if (bitShift && i - wordShift > 0) word |= words[i - wordShift - 1] >> (64 - bitShift);
+            r.words[i] = word;
+        }
+        r.trim();
+        return r;
+    }
+    BitMask operator>>(int shift) const {
+        BitMask r;
+        int wordShift = shift >> 6, bitShift = shift & 63;
+        for (int i = 0; i + wordShift < WORDS; ++i) {
+            quint64 word = words[i + wordShift] >> bitShift;
+            if (bitShift && i + wordShift + 1 < WORDS) word |= words[i + wordShift + 1] << (64 - bitShift);
+            r.words[i] = word;
+        }
+        return r;
+    }
+    BitMask operator~() const {
+        BitMask r;
+        for (int i = 0; i < WORDS; ++i) r.words[i] = ~words[i];
+        r.trim();
+        return r;
+    }
+    bool operator==(const BitMask &other) const {
+        for (int i = 0; i < WORDS; ++i) {
+            if (words[i] != other.words[i]) return false;
+        }
+        return true;
+    }
+    bool operator!=(const BitMask &other) const { return !(*this == other); }
+
+    quint64 words[WORDS];
+
+private:
+    void trim() {
+        if (Bits % 64) words[WORDS - 1] &= (quint64(1) << (Bits % 64)) - 1;
+    }
+};
+
+#endif // BITBOARD_H
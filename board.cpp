@@ -1,69 +1,289 @@
 #include "Board.h"
+#include "latencyprobe.h"
+#include "tracing.h"
+#include <cstring>
 
-Board::Board(int numShips) : numShips(numShips) {
-    grid = QVector<QVector<char>>(GRID_SIZE, QVector<char>(GRID_SIZE, '~'));
+void Fleet::clear() {
+    memset(this, 0, sizeof(Fleet));
+    memset(cellShip, NO_SHIP, sizeof(cellShip));
+}
+
+QVector<CellMask> shipPositions(const RuleSet &rules, int shipLength) {
+    QVector<CellMask> positions;
+    for (int vertical = 0; vertical < 2; ++vertical) {
+        for (int row = 0; row + (vertical ? shipLength : 1) <= rules.rows; ++row) {
+            for (int col = 0; col + (vertical ? 1 : shipLength) <= rules.cols; ++col) {
+                CellMask ship;
+                for (int i = 0; i < shipLength; ++i) {
+                    ship.set(vertical ? (row + i) * rules.cols + col : row * rules.cols + col + i);
+                }
+                positions.append(ship);
+            }
+        }
+    }
+    return positions;
+}
+
+Board::Board(const RuleSet &rules) : gridRows(rules.rows), gridCols(rules.cols) {
+    resetBoard();
 }
 
 void Board::resetBoard() {
-    grid = QVector<QVector<char>>(GRID_SIZE, QVector<char>(GRID_SIZE, '~'));
+    TRACE_SPAN("board", "resetBoard");
+    memset(grid, SENTINEL, sizeof(grid));
+    for (int row = 0; row < gridRows; ++row) {
+        memset(grid + paddedCell(row, 0), '~', gridCols);
+    }
     ships.clear();
+    untried = CellMask::firstBits(cells());
+    hits = CellMask();
 }
 
 bool Board::isValidPosition(int row, int col, bool isVertical, int shipLength) {
+    LATENCY_PROBE("board.isValidPosition");
     if (isVertical) {
-        if (row + shipLength > GRID_SIZE) return false;
-        for (int i = 0; i < shipLength; i++) {
-            if (grid[row + i][col] != '~') return false;
-        }
+        if (row + shipLength > gridRows) return false;
     } else {
-        if (col + shipLength > GRID_SIZE) return false;
-        for (int i = 0; i < shipLength; i++) {
-            if (grid[row][col + i] != '~') return false;
-        }
+        if (col + shipLength > gridCols) return false;
+    }
+    int step = isVertical ? PADDED_STRIDE : 1;
+    for (int i = 0, cell = paddedCell(row, col); i < shipLength; i++, cell += step) {
+        if (grid[cell] != '~') return false;
     }
     return true;
 }
 
 void Board::placeShip(int row, int col, bool isVertical, int shipLength, char symbol) {
-    Ship ship = {row, col, isVertical, shipLength};
+    LATENCY_PROBE("board.placeShip");
+    TRACE_SPAN("board", "placeShip");
+    Q_ASSERT(ships.count < MAX_SHIPS);
+    quint8 id = ships.count++;
+    ships.row[id] = row;
+    ships.col[id] = col;
+    ships.length[id] = shipLength;
+    ships.vertical[id] = isVertical;
+    ships.hits[id] = 0;
+    ships.afloat++;
     if (isVertical) {
         for (int i = 0; i < shipLength; i++) {
-            grid[row + i][col] = symbol;
-            ship.positions.append(qMakePair(row + i, col));
+            grid[paddedCell(row + i, col)] = symbol;
+            ships.cellShip[(row + i) * gridCols + col] = id;
         }
     } else {
         for (int i = 0; i < shipLength; i++) {
-            grid[row][col + i] = symbol;
-            ship.positions.append(qMakePair(row, col + i));
+            grid[paddedCell(row, col + i)] = symbol;
+            ships.cellShip[row * gridCols + col + i] = id;
         }
     }
-    ships.append(ship);
 }
 
 bool Board::attack(int row, int col) {
-    if (grid[row][col] == 'S') {
-        grid[row][col] = 'X';
+    LATENCY_PROBE("board.attack");
+    TRACE_SPAN("board", "attack");
+    untried.reset(row * gridCols + col);
+    char &value = grid[paddedCell(row, col)];
+    if (value == 'S') {
+        value = 'X';
+        hits.set(row * gridCols + col);
+        quint8 id = ships.cellShip[row * gridCols + col];
+        if (++ships.hits[id] == ships.length[id]) ships.afloat--;
         return true;
-    } else if (grid[row][col] == '~') {
-        grid[row][col] = 'O';
+    } else if (value == '~') {
+        value = 'O';
     }
     return false;
 }
 
-bool Board::hasShipsRemaining() {
-    for (const auto& row : grid) {
-        for (const auto& cell : row) {
-            if (cell == 'S') return true;
+// Resolves a whole salvo in one pass over the mask words; same per-cell rules
+// as attack().
+SalvoResult Board::attackBatch(const CellMask &shots) {
+    LATENCY_PROBE("board.attackBatch");
+    TRACE_SPAN("board", "attackBatch");
+    SalvoResult result;
+    result.shots = shots & untried;
+    for (int w = 0; w < CellMask::WORDS; ++w) {
+        quint64 word = result.shots.words[w];
+        untried.words[w] &= ~word;
+        while (word) {
+            int cell = w * 64 + qCountTrailingZeroBits(word);
+            word &= word - 1;
+            char &value = grid[paddedCell(cell / gridCols, cell % gridCols)];
+            if (value != 'S') {
+                if (value == '~') value = 'O';
+                continue;
+            }
+            value = 'X';
+            hits.set(cell);
+            result.hits.set(cell);
+            quint8 id = ships.cellShip[cell];
+            if (++ships.hits[id] == ships.length[id]) {
+                ships.afloat--;
+                int step = ships.vertical[id] ? gridCols : 1;
+                int first = ships.row[id] * gridCols + ships.col[id];
+                for (int i = 0; i < ships.length[id]; ++i) result.sunk.set(first + i * step);
+            }
         }
     }
-    return false;
+    return result;
+}
+
+bool Board::hasShipsRemaining() const {
+    return ships.afloat > 0;
 }
 
 // New methods for accessing the grid
 char Board::getCell(int row, int col) const {
-    return grid[row][col];
+    return grid[paddedCell(row, col)];
 }
 
 void Board::setCell(int row, int col, char value) {
-    grid[row][col] = value;
+    grid[paddedCell(row, col)] = value;
+    if (value == 'X') hits.set(row * gridCols + col);
+    else hits.reset(row * gridCols + col);
+    if (value == 'X' || value == 'O') {
+        untried.reset(row * gridCols + col);
+    } else {
+        untried.set(row * gridCols + col);
+    }
+}
+
+CellMask Board::untriedMask() const {
+    return untried;
+}
+
+CellMask Board::hitMask() const {
+    return hits;
+}
+
+// Length of the shortest ship that still has an unhit cell, 0 if all are sunk.
+int Board::smallestShipRemaining() const {
+    int smallest = 0;
+    for (int id = 0; id < ships.count; ++id) {
+        if (ships.hits[id] < ships.length[id] && (smallest == 0 || ships.length[id] < smallest)) {
+            smallest = ships.length[id];
+        }
+    }
+    return smallest;
+}
+
+// Ship id covering the cell, or -1 for open water.
+int Board::shipAt(int row, int col) const {
+    quint8 id = ships.cellShip[row * gridCols + col];
+    return id == NO_SHIP ? -1 : id;
+}
+
+bool Board::isShipSunk(int shipId) const {
+    return ships.hits[shipId] == ships.length[shipId];
+}
+
+bool Board::isSunkAt(int row, int col) const {
+    int id = shipAt(row, col);
+    return id >= 0 && isShipSunk(id);
+}
+
+int Board::shipsAfloat() const {
+    return ships.afloat;
+}
+
+const Fleet &Board::fleet() const {
+    return ships;
+}
+
+int Board::rows() const {
+    return gridRows;
+}
+
+int Board::cols() const {
+    return gridCols;
+}
+
+int Board::cells() const {
+    return gridRows * gridCols;
+}
+
+bool Board::isInside(int row, int col) const {
+    return row >= 0 && row < gridRows && col >= 0 && col < gridCols;
+}
+
+Board Board::unknownFleet(const RuleSet &rules) {
+    Board board(rules);
+    for (int shipLength : rules.shipLengths) {
+        quint8 id = board.ships.count++;
+        board.ships.length[id] = shipLength;
+        board.ships.afloat++;
+    }
+    return board;
+}
+
+void Board::recordMiss(int row, int col) {
+    untried.reset(row * gridCols + col);
+    grid[paddedCell(row, col)] = 'O';
+}
+
+void Board::recordHit(int row, int col) {
+    int cell = row * gridCols + col;
+    if (grid[paddedCell(row, col)] == 'X') return;
+    untried.reset(cell);
+    hits.set(cell);
+    grid[paddedCell(row, col)] = 'X';
+    int id = afloatShip(0);
+    ships.cellShip[cell] = id < 0 ? NO_SHIP : id;
+}
+
+bool Board::recordSunk(int row, int col, int length) {
+    recordHit(row, col);
+    int cell = row * gridCols + col;
+
+    // Candidates: windows of open hits through the cell as long as a ship
+    // afloat. A window covering its whole run of hits wins, then the longest;
+    // within a run, the window that ends at the sinking shot.
+    CellMask best;
+    int bestKey = 0;
+    int bestLength = 0;
+    for (int step : {1, gridCols}) {
+        int first = cell, last = cell;
+        while ((step == 1 ? first % gridCols > 0 : first >= gridCols) && isOpenHit(first - step)) first -= step;
+        while ((step == 1 ? last % gridCols < gridCols - 1 : last + gridCols < cells()) && isOpenHit(last + step)) last += step;
+        int run = (last - first) / step + 1;
+        for (int shipLength = run; shipLength >= 1; --shipLength) {
+            if ((length > 0 && shipLength != length) || afloatShip(shipLength) < 0) continue;
+            int key = (shipLength == run ? MAX_GRID_SIZE : 0) + shipLength;
+            if (key <= bestKey) continue;
+            int start = qMax(first, cell - (shipLength - 1) * step);
+            best = CellMask();
+            for (int i = 0; i < shipLength; ++i) best.set(start + i * step);
+            bestKey = key;
+            bestLength = shipLength;
+        }
+    }
+    if (bestKey == 0) return false;
+
+    int id = afloatShip(bestLength);
+    int first = best.select(0);
+    ships.row[id] = first / gridCols;
+    ships.col[id] = first % gridCols;
+    ships.vertical[id] = bestLength > 1 && first + gridCols < cells() && best.test(first + gridCols);
+    ships.hits[id] = bestLength;
+    ships.afloat--;
+
+    // Open hits that were parked on this ship move to one still afloat
+    int other = afloatShip(0);
+    for (int at = 0; at < cells(); ++at) {
+        if (best.test(at)) ships.cellShip[at] = id;
+        else if (ships.cellShip[at] == id) ships.cellShip[at] = other < 0 ? NO_SHIP : other;
+    }
+    return true;
+}
+
+// Some ship still afloat with this length (any length for 0), or -1.
+int Board::afloatShip(int length) const {
+    for (int id = 0; id < ships.count; ++id) {
+        if (ships.hits[id] < ships.length[id] && (length == 0 || ships.length[id] == length)) return id;
+    }
+    return -1;
+}
+
+bool Board::isOpenHit(int cell) const {
+    quint8 id = ships.cellShip[cell];
+    return grid[paddedCell(cell / gridCols, cell % gridCols)] == 'X' && id != NO_SHIP && !isShipSunk(id);
 }
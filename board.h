@@ -3,35 +3,90 @@
 
 #include <QVector>
 #include <QPair>
+#include "bitboard.h"
+#include "gridgeometry.h"
+#include "ruleset.h"
 
-const int GRID_SIZE = 7;
-const int MIN_SHIP_SIZE = 3;
-const int MAX_SHIP_SIZE = 5;
+const quint8 NO_SHIP = 0xFF;
 
-struct Ship {
-    int row;
-    int col;
-    bool isVertical;
-    int size;
-    QVector<QPair<int, int>> positions;
+// Cells are numbered row * cols + col for the board's own column count.
+typedef BitMask<MAX_GRID_CELLS> CellMask;
+
+// Struct-of-arrays fleet with a cell -> ship id table. Trivially copyable,
+// so a whole fleet copies with one memcpy and hit attribution is a lookup.
+struct Fleet {
+    quint8 count;
+    quint8 afloat;
+    quint8 row[MAX_SHIPS];
+    quint8 col[MAX_SHIPS];
+    quint8 length[MAX_SHIPS];
+    bool vertical[MAX_SHIPS];
+    quint8 hits[MAX_SHIPS];
+    quint8 cellShip[MAX_GRID_CELLS];
+
+    void clear();
+};
+
+// Outcome of Board::attackBatch. shots holds the cells actually fired (already
+// tried cells are dropped), sunk every cell of each ship the salvo finished.
+struct SalvoResult {
+    CellMask shots;
+    CellMask hits;
+    CellMask sunk;
 };
 
+// Every position of a ship of this length on the rules' grid, as cell masks.
+QVector<CellMask> shipPositions(const RuleSet &rules, int shipLength);
+
 class Board {
 public:
-    Board(int numShips = 3);
+    explicit Board(const RuleSet &rules = RuleSet());
 
     void resetBoard();
     bool isValidPosition(int row, int col, bool isVertical, int shipLength);
     void placeShip(int row, int col, bool isVertical, int shipLength, char symbol = 'S');
     bool attack(int row, int col);
-    bool hasShipsRemaining();
+    SalvoResult attackBatch(const CellMask &shots);
+    bool hasShipsRemaining() const;
     char getCell(int row, int col) const;
     void setCell(int row, int col, char value) ;
+    CellMask untriedMask() const;
+    CellMask hitMask() const;
+    int smallestShipRemaining() const;
+    int shipAt(int row, int col) const;
+    bool isShipSunk(int shipId) const;
+    bool isSunkAt(int row, int col) const;
+    int shipsAfloat() const;
+    const Fleet &fleet() const;
+    int rows() const;
+    int cols() const;
+    int cells() const;
+    bool isInside(int row, int col) const;
+
+    // An opponent's board known only from shot results (engine protocol):
+    // the fleet's lengths are known, its positions are learned as ships sink.
+    // Open hits are attributed to some ship still afloat.
+    static Board unknownFleet(const RuleSet &rules);
+    void recordMiss(int row, int col);
+    void recordHit(int row, int col);
+    // Sinks the ship through this hit. With length 0 the length is inferred
+    // from the line of open hits. False if no afloat ship fits.
+    bool recordSunk(int row, int col, int length = 0);
+
+    // Padded-id access for the bot hot paths; SENTINEL outside the board.
+    char cellAt(int cell) const { return grid[cell]; }
+    bool isUntriedAt(int cell) const { return grid[cell] != 'X' && grid[cell] != 'O' && grid[cell] != SENTINEL; }
 
 private:
-    QVector<QVector<char>> grid;
-    QVector<Ship> ships;
-    int numShips;
+    char grid[PADDED_CELLS]; // indexed by paddedCell(row, col)
+    Fleet ships;
+    CellMask untried;
+    CellMask hits;
+    int gridRows;
+    int gridCols;
+
+    int afloatShip(int length) const;
+    bool isOpenHit(int cell) const;
 };
 
 #endif // BOARD_H
@@ -0,0 +1,268 @@
+#include "boardfuzzer.h"
+#include "botplayer.h"
+#include "enginerandom.h"
+
+BoardFuzzer::BoardFuzzer(const RuleSet &rules) : rules(rules), attacks(0) {
+}
+
+QString BoardFuzzer::failure() const {
+    return firstFailure;
+}
+
+quint64 BoardFuzzer::attacksChecked() const {
+    return attacks;
+}
+
+bool BoardFuzzer::fail(int game, const QString &what) {
+    firstFailure = QString("game %1: %2").arg(game).arg(what);
+    return false;
+}
+
+bool BoardFuzzer::run(int games) {
+    if (!checkExpertSink()) return false;
+    for (int game = 0; game < games; ++game) {
+        if (!playGame(game)) return false;
+    }
+    return true;
+}
+
+// Classic fleet with the cruiser on row 5, hit at (5, 4) and (5, 5), then sunk
+// at (5, 3). No hit is left open, so nothing around the wreck may stay queued.
+bool BoardFuzzer::checkExpertSink() {
+    RuleSet classic = RuleSet::classic();
+    Board board(classic);
+    board.placeShip(0, 0, false, 5);
+    board.placeShip(2, 0, false, 4);
+    board.placeShip(5, 3, false, 3);
+    board.placeShip(8, 0, false, 3);
+    board.placeShip(9, 5, false, 2);
+
+    BotPlayer bot(BotPlayer::Expert);
+    const int shots[3][2] = {{5, 4}, {5, 5}, {5, 3}};
+    for (const auto &cell : shots) {
+        BotShot shot = {cell[0], cell[1], board.attack(cell[0], cell[1]), false};
+        shot.sunk = shot.hit && board.isSunkAt(cell[0], cell[1]);
+        bot.observe(board, shot);
+    }
+    if (!board.isSunkAt(5, 3)) {
+        firstFailure = "expert scenario: the cruiser at (5, 3) did not sink";
+        return false;
+    }
+
+    for (int r = 0; r < classic.rows; ++r) {
+        for (int c = 0; c < classic.cols; ++c) {
+            if (bot.isTargetQueued(r, c)) {
+                firstFailure = QString("expert scenario: (%1, %2) still queued after the sink").arg(r).arg(c);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool BoardFuzzer::placeFleet(Board &board, SparseBoard &sparse, ReferenceBoard &reference, int game) {
+    for (int shipLength : rules.shipLengths) {
+        bool isVertical;
+        int row, col;
+        bool valid;
+        do {
+            isVertical = engineRandom(2) != 0;
+            row = engineRandom(rules.rows);
+            col = engineRandom(rules.cols);
+            valid = board.isValidPosition(row, col, isVertical, shipLength);
+            if (valid != reference.isValidPosition(row, col, isVertical, shipLength) ||
+                valid != sparse.isValidPosition(row, col, isVertical, shipLength)) {
+                return fail(game, QString("isValidPosition(%1, %2, %3, %4) disagrees with reference")
+                                      .arg(row).arg(col).arg(isVertical).arg(shipLength));
+            }
+        } while (!valid);
+        board.placeShip(row, col, isVertical, shipLength);
+        sparse.placeShip(row, col, isVertical, shipLength);
+        reference.placeShip(row, col, isVertical, shipLength);
+    }
+    return true;
+}
+
+bool BoardFuzzer::checkAttack(const Board &board, const SparseBoard &sparse, ReferenceBoard &reference, int row, int col,
+                              bool hit, bool sparseHit, bool referenceHit, bool wasUntried, int game) {
+    QString cell = QString("(%1, %2)").arg(row).arg(col);
+    if (!wasUntried) return fail(game, "cell attacked twice " + cell);
+    if (hit != referenceHit) return fail(game, "attack result differs from reference at " + cell);
+    if (sparseHit != referenceHit) return fail(game, "sparse attack result differs from reference at " + cell);
+
+    int hits = 0, misses = 0, untouched = 0;
+    bool shipCellLeft = false;
+    for (int r = 0; r < rules.rows; ++r) {
+        for (int c = 0; c < rules.cols; ++c) {
+            char value = board.getCell(r, c);
+            if (value != reference.getCell(r, c)) {
+                return fail(game, QString("cell (%1, %2) differs from reference").arg(r).arg(c));
+            }
+            if (sparse.getCell(r, c) != value) {
+                return fail(game, QString("sparse cell (%1, %2) differs from reference").arg(r).arg(c));
+            }
+            if (value == 'X') hits++;
+            else if (value == 'O') misses++;
+            else untouched++;
+            if (value == 'S') shipCellLeft = true;
+        }
+    }
+
+    if (hits + misses + untouched != rules.cells()) return fail(game, "cell counts do not add up");
+    if (untouched != board.untriedMask().count()) return fail(game, "untried mask out of sync with the grid");
+    if (hits != board.hitMask().count()) return fail(game, "hit mask out of sync with the grid");
+    if (untouched != sparse.untriedCount()) return fail(game, "sparse untried count out of sync with the grid");
+    if (board.untriedMask().test(row * rules.cols + col)) return fail(game, "attacked cell still untried " + cell);
+
+    if (board.hasShipsRemaining() != shipCellLeft || reference.hasShipsRemaining() != shipCellLeft ||
+        sparse.hasShipsRemaining() != shipCellLeft) {
+        return fail(game, "fleet-alive flag disagrees with a full scan");
+    }
+    if (board.isSunkAt(row, col) != reference.isSunkAt(row, col) ||
+        sparse.isSunkAt(row, col) != reference.isSunkAt(row, col)) {
+        return fail(game, "sunk state differs from reference at " + cell);
+    }
+    if (board.smallestShipRemaining() != reference.smallestShipRemaining() ||
+        sparse.smallestShipRemaining() != reference.smallestShipRemaining()) {
+        return fail(game, "smallest ship afloat differs from reference");
+    }
+    attacks++;
+    return true;
+}
+
+// Random salvo through Board::attackBatch, replayed shot by shot on the sparse
+// and reference boards. Sometimes includes a random, possibly tried, cell,
+// which the batch must skip.
+bool BoardFuzzer::fireSalvo(Board &board, SparseBoard &sparse, ReferenceBoard &reference, int sunkEvents[], int game) {
+    CellMask untriedBefore = board.untriedMask();
+    CellMask untried = untriedBefore;
+    CellMask shots;
+    int count = 1 + engineRandom(4);
+    for (int i = 0; i < count && !untried.isEmpty(); ++i) {
+        int cell = untried.select(engineRandom(untried.count()));
+        shots.set(cell);
+        untried.reset(cell);
+    }
+    if (engineRandom(2)) shots.set(engineRandom(rules.cells()));
+
+    bool sunkBefore[MAX_SHIPS];
+    for (int id = 0; id < board.fleet().count; ++id) sunkBefore[id] = board.isShipSunk(id);
+
+    SalvoResult salvo = board.attackBatch(shots);
+    if (salvo.shots != (shots & untriedBefore)) return fail(game, "salvo fired the wrong cells");
+    if (!(salvo.shots & board.untriedMask()).isEmpty()) return fail(game, "salvo left a fired cell untried");
+    if (!(salvo.hits & ~salvo.shots).isEmpty()) return fail(game, "salvo hit a cell it did not fire");
+
+    for (int cell = 0; cell < rules.cells(); ++cell) {
+        if (!shots.test(cell)) continue;
+        int row = cell / rules.cols;
+        int col = cell % rules.cols;
+        if (!salvo.shots.test(cell)) continue;
+        bool sparseHit = sparse.attack(row, col);
+        bool referenceHit = reference.attack(row, col);
+        if (salvo.hits.test(cell) != referenceHit || sparseHit != referenceHit) {
+            return fail(game, QString("salvo result differs from reference at (%1, %2)").arg(row).arg(col));
+        }
+    }
+    int last = salvo.shots.select(salvo.shots.count() - 1);
+    if (last >= 0) {
+        int row = last / rules.cols;
+        int col = last % rules.cols;
+        bool hit = salvo.hits.test(last);
+        if (!checkAttack(board, sparse, reference, row, col, hit, hit, hit, true, game)) return false;
+    }
+
+    // The sunk mask must hold exactly the ships this salvo finished
+    for (int cell = 0; cell < rules.cells(); ++cell) {
+        int id = board.shipAt(cell / rules.cols, cell % rules.cols);
+        bool finished = id >= 0 && board.isShipSunk(id) && !sunkBefore[id];
+        if (salvo.sunk.test(cell) != finished) return fail(game, "salvo sunk mask is wrong");
+    }
+    for (int id = 0; id < board.fleet().count; ++id) {
+        if (board.isShipSunk(id) && !sunkBefore[id]) sunkEvents[id]++;
+    }
+    return true;
+}
+
+// Fires the cells Board tried since `untriedBefore` at the compact board, then
+// compares the two.
+bool BoardFuzzer::checkCompact(const Board &board, CompactBoard<> &compact, const CellMask &untriedBefore, int game) {
+    CellMask fired = untriedBefore & ~board.untriedMask();
+    for (int cell = 0; cell < rules.cells(); ++cell) {
+        int row = cell / rules.cols;
+        int col = cell % rules.cols;
+        if (fired.test(cell) && compact.attack(row, col) != (board.getCell(row, col) == 'X')) {
+            return fail(game, QString("compact attack result differs at (%1, %2)").arg(row).arg(col));
+        }
+        if (compact.getCell(row, col) != board.getCell(row, col) || compact.shipAt(row, col) != board.shipAt(row, col)) {
+            return fail(game, QString("compact cell (%1, %2) differs from Board").arg(row).arg(col));
+        }
+    }
+    if (compact.shipsAfloat() != board.shipsAfloat() || compact.smallestShipRemaining() != board.smallestShipRemaining()) {
+        return fail(game, "compact fleet differs from Board");
+    }
+    return true;
+}
+
+bool BoardFuzzer::playGame(int game) {
+    Board board(rules);
+    SparseBoard sparse(rules.rows, rules.cols);
+    ReferenceBoard reference(rules.rows, rules.cols);
+    if (!placeFleet(board, sparse, reference, game)) return false;
+    CompactBoard<> compact = CompactBoard<>::fromBoard(board);
+
+    // Shooter: one of the bots, uniformly random legal shots, or random salvos
+    int shooter = engineRandom(BotPlayer::DIFFICULTY_COUNT + 2);
+    BotPlayer bot(BotPlayer::Difficulty(qMin(shooter, BotPlayer::DIFFICULTY_COUNT - 1)));
+
+    int sunkEvents[MAX_SHIPS] = {0};
+    int shots = 0;
+    while (board.hasShipsRemaining()) {
+        if (++shots > rules.cells()) return fail(game, "more shots than cells");
+        CellMask untriedBefore = board.untriedMask();
+        if (shooter == BotPlayer::DIFFICULTY_COUNT + 1) {
+            if (!fireSalvo(board, sparse, reference, sunkEvents, game)) return false;
+            if (!checkCompact(board, compact, untriedBefore, game)) return false;
+            continue;
+        }
+
+        int row, col;
+        bool hit;
+        bool wasUntried;
+        bool wasSunk;
+        if (shooter < BotPlayer::DIFFICULTY_COUNT) {
+            BotShot shot = bot.attack(board);
+            if (shot.row < 0) return fail(game, "bot found no shot with ships remaining");
+            row = shot.row;
+            col = shot.col;
+            hit = shot.hit;
+            wasUntried = untriedBefore.test(row * rules.cols + col);
+            wasSunk = false;
+            if (shot.sunk != board.isSunkAt(row, col)) return fail(game, "bot reported the wrong sunk state");
+        } else {
+            CellMask untried = board.untriedMask();
+            int cell = untried.select(engineRandom(untried.count()));
+            row = cell / rules.cols;
+            col = cell % rules.cols;
+            wasUntried = true;
+            wasSunk = board.isSunkAt(row, col);
+            hit = board.attack(row, col);
+        }
+
+        bool sparseHit = sparse.attack(row, col);
+        bool referenceHit = reference.attack(row, col);
+        if (!checkAttack(board, sparse, reference, row, col, hit, sparseHit, referenceHit, wasUntried, game)) return false;
+        if (!checkCompact(board, compact, untriedBefore, game)) return false;
+
+        if (hit && !wasSunk && board.isSunkAt(row, col)) {
+            sunkEvents[board.shipAt(row, col)]++;
+        }
+    }
+
+    for (int id = 0; id < board.fleet().count; ++id) {
+        if (sunkEvents[id] != 1) {
+            return fail(game, QString("ship %1 sank %2 times").arg(id).arg(sunkEvents[id]));
+        }
+    }
+    return true;
+}
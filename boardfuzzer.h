@@ -0,0 +1,39 @@
+#ifndef BOARDFUZZER_H
+#define BOARDFUZZER_H
+
+#include <QString>
+#include "board.h"
+#include "compactboard.h"
+#include "referenceboard.h"
+#include "sparseboard.h"
+
+// Plays random legal games at full speed and, after every attack, checks Board
+// and SparseBoard against ReferenceBoard and the game invariants (cell
+// accounting, no repeated shots, fleet-alive flag, exactly one sunk event per ship).
+// A CompactBoard follows every game and must match Board cell for cell.
+// Before the games, an Expert bot must let go of its targets once the only
+// ship it was chasing sinks.
+class BoardFuzzer {
+public:
+    explicit BoardFuzzer(const RuleSet &rules);
+
+    bool run(int games);
+    QString failure() const;
+    quint64 attacksChecked() const;
+
+private:
+    RuleSet rules;
+    quint64 attacks;
+    QString firstFailure;
+
+    bool checkExpertSink();
+    bool playGame(int game);
+    bool placeFleet(Board &board, SparseBoard &sparse, ReferenceBoard &reference, int game);
+    bool fireSalvo(Board &board, SparseBoard &sparse, ReferenceBoard &reference, int sunkEvents[], int game);
+    bool checkAttack(const Board &board, const SparseBoard &sparse, ReferenceBoard &reference, int row, int col,
+                     bool hit, bool sparseHit, bool referenceHit, bool wasUntried, int game);
+    bool checkCompact(const Board &board, CompactBoard<> &compact, const CellMask &untriedBefore, int game);
+    bool fail(int game, const QString &what);
+};
+
+#endif // BOARDFUZZER_H
@@ -0,0 +1,370 @@
+#include "botplayer.h"
+#include "constraintpropagator.h"
+#include "enginerandom.h"
+#include "heatmap.h"
+#include "huntpolicy.h"
+#include "latencyprobe.h"
+#include "placementoptimizer.h"
+#include "tracing.h"
+
+BotPlayer::BotPlayer(Difficulty difficulty)
+    : level(difficulty), pendingMove(HuntMove), huntingMode(false), currentDirection(0),
+    sweep{Right, Down, Left, Up}
+{
+}
+
+BotPlayer::Difficulty BotPlayer::difficultyFromName(const QString &name) {
+    if (name == "Medium") return Medium;
+    if (name == "Hard") return Hard;
+    if (name == "Expert") return Expert;
+    return Easy;
+}
+
+const char *BotPlayer::difficultyName(Difficulty difficulty) {
+    switch (difficulty) {
+    case Medium: return "Medium";
+    case Hard: return "Hard";
+    case Expert: return "Expert";
+    default: return "Easy";
+    }
+}
+
+void BotPlayer::placeShips(Board &board, const RuleSet &rules) {
+    for (int shipLength : rules.shipLengths) {
+        bool isVertical;
+        int row, col;
+        // Orientation is re-rolled per attempt: a fixed one can run out of room
+        do {
+            isVertical = engineRandom(2) != 0;
+            row = engineRandom(board.rows());
+            col = engineRandom(board.cols());
+        } while (!board.isValidPosition(row, col, isVertical, shipLength));
+        board.placeShip(row, col, isVertical, shipLength);
+    }
+}
+
+void BotPlayer::placeFleet(Board &board, const RuleSet &rules) const {
+    if (level == Easy) {
+        placeShips(board, rules);
+        return;
+    }
+    PlacementOptimizer optimizer(rules);
+    if (!opponentShots.isEmpty()) optimizer.setShotModel(opponentShots);
+    optimizer.place(board);
+}
+
+void BotPlayer::setOpponentProfile(const OpponentProfile &profile, const RuleSet &rules) {
+    favouriteCells = profile.favouriteCells(rules);
+    opponentShots = profile.shotModel();
+
+    // Hard follows a hit along the opponent's usual orientation first
+    static const Direction horizontalFirst[4] = {Right, Down, Left, Up};
+    static const Direction verticalFirst[4] = {Down, Right, Up, Left};
+    bool vertical = profile.isReady() && profile.verticalShare() > 0.5;
+    for (int i = 0; i < 4; ++i) sweep[i] = vertical ? verticalFirst[i] : horizontalFirst[i];
+}
+
+void BotPlayer::setPolicyTable(const PolicyTable &table) {
+    policy = table;
+}
+
+BotPlayer::Difficulty BotPlayer::difficulty() const {
+    return level;
+}
+
+bool BotPlayer::isTargetQueued(int row, int col) const {
+    return expertTargets.contains(paddedCell(row, col));
+}
+
+void BotPlayer::reset() {
+    botTargets.clear();
+    huntingMode = false;
+    possibleMoves.clear();
+    expertTargets.clear();
+    lastHits.clear();
+    currentDirection = 0;
+    pendingMove = HuntMove;
+    ruledOut = CellMask();
+}
+
+BotShot BotPlayer::attack(Board &target) {
+    static const char *const probeNames[DIFFICULTY_COUNT] = {
+        "bot.Easy", "bot.Medium", "bot.Hard", "bot.Expert"
+    };
+    LatencyProbe probe(LatencyRecorder::target(probeNames[level]));
+    TRACE_SPAN("bot", probeNames[level]);
+
+    BotShot none = {-1, -1, false, false};
+    int row, col;
+    if (!chooseShot(target, row, col)) return none;
+    BotShot shot = fire(target, row, col);
+    observe(target, shot);
+    return shot;
+}
+
+// Easy scatters the salvo over random untried cells; the others pick it
+// jointly from the placement heatmap.
+SalvoResult BotPlayer::attackSalvo(Board &target, int shots) {
+    static const char *const probeNames[DIFFICULTY_COUNT] = {
+        "salvo.Easy", "salvo.Medium", "salvo.Hard", "salvo.Expert"
+    };
+    LatencyProbe probe(LatencyRecorder::target(probeNames[level]));
+    TRACE_SPAN("bot", probeNames[level]);
+
+    CellMask salvo;
+    if (level == Easy) {
+        CellMask untried = target.untriedMask();
+        for (int i = 0; i < shots && !untried.isEmpty(); ++i) {
+            int cell = untried.select(engineRandom(untried.count()));
+            salvo.set(cell);
+            untried.reset(cell);
+        }
+    } else {
+        salvo = ShotHeatmap::chooseSalvo(target, shots, favouriteCells);
+    }
+    return target.attackBatch(salvo);
+}
+
+BotShot BotPlayer::fire(Board &target, int row, int col) {
+    BotShot shot = {row, col, false, false};
+    shot.hit = target.attack(row, col);
+    shot.sunk = shot.hit && target.isSunkAt(row, col);
+    return shot;
+}
+
+bool BotPlayer::chooseShot(const Board &target, int &row, int &col) {
+    if (policy.lookup(target, row, col)) {
+        pendingMove = PolicyMove;
+        return true;
+    }
+    if ((level == Hard || level == Expert) && endgame.enumerate(target) && endgame.chooseShot(row, col)) {
+        pendingMove = EndgameMove;
+        return true;
+    }
+
+    // Every difficulty skips cells that cannot hold a ship; all but Easy
+    // also take a sure hit before anything else
+    ForcedCells forced = ConstraintPropagator::propagate(target);
+    ruledOut = (target.untriedMask() & ~forced.empty).isEmpty() ? CellMask() : forced.empty;
+    if (level != Easy && !forced.ship.isEmpty()) {
+        int cell = forced.ship.select(0);
+        row = cell / target.cols();
+        col = cell % target.cols();
+        pendingMove = ForcedMove;
+        return true;
+    }
+    switch (level) {
+    case Medium: return mediumShot(target, row, col);
+    case Hard: return hardShot(target, row, col);
+    case Expert: return expertShot(target, row, col);
+    default: return easyShot(target, row, col);
+    }
+}
+
+void BotPlayer::observe(const Board &target, const BotShot &shot) {
+    int cell = paddedCell(shot.row, shot.col);
+    switch (level) {
+    case Hard:
+        if (pendingMove == SweepMove) {
+            if (shot.hit) {
+                lastHits.pushBack(cell);
+            } else {
+                // Change direction after a miss
+                currentDirection = (currentDirection + 1) % 4;
+            }
+        } else if (pendingMove == RestartMove) {
+            if (shot.hit) {
+                lastHits.pushBack(cell);
+                currentDirection = 0;
+            }
+        } else if (shot.hit) {
+            addAdjacentPositions(target, shot.row, shot.col);
+            huntingMode = true;
+        }
+        break;
+    case Expert:
+        rescoreExpertTargets(target, cell, shot);
+        break;
+    default:
+        break;
+    }
+}
+
+// Untried and not ruled out; false for the border. `cell` is a padded id.
+bool BotPlayer::isWorthShooting(const Board &target, int cell) const {
+    return target.isUntriedAt(cell) && !ruledOut.test(paddedRow(cell) * target.cols() + paddedCol(cell));
+}
+
+// Hunt-phase shot for the smarter bots: parity lattice of the smallest ship left.
+bool BotPlayer::huntShot(const Board &target, int &row, int &col) {
+    return ParityHuntPolicy::chooseShot(target.untriedMask() & ~ruledOut, target.smallestShipRemaining(),
+                                        target.rows(), target.cols(), row, col, favouriteCells);
+}
+
+bool BotPlayer::easyShot(const Board &target, int &row, int &col) {
+    if (target.untriedMask().isEmpty()) return false;
+
+    do {
+        row = engineRandom(target.rows());
+        col = engineRandom(target.cols());
+    } while (!isWorthShooting(target, paddedCell(row, col)));
+    return true;
+}
+
+bool BotPlayer::mediumShot(const Board &target, int &row, int &col) {
+    if (botTargets.isEmpty()) {
+        pendingMove = HuntMove;
+        return huntShot(target, row, col);
+    }
+
+    int cell = botTargets.takeAt(engineRandom(botTargets.size()));
+    row = paddedRow(cell);
+    col = paddedCol(cell);
+    pendingMove = QueuedMove;
+    return true;
+}
+
+bool BotPlayer::smartShot(const Board &target, int &row, int &col) {
+    pendingMove = HuntMove;
+    while (huntingMode && !possibleMoves.isEmpty()) {
+        // Continue hunting in the vicinity of the last hit
+        int cell = possibleMoves.popFront();
+        if (!isWorthShooting(target, cell)) continue;
+        row = paddedRow(cell);
+        col = paddedCol(cell);
+        return true;
+    }
+
+    // Search for a new target
+    huntingMode = false; // Ensure hunting mode is off when starting a new search
+    possibleMoves.clear(); // Clear any leftover moves
+    return huntShot(target, row, col);
+}
+
+void BotPlayer::addAdjacentPositions(const Board &target, int row, int col) {
+    int cell = paddedCell(row, col);
+    for (int dir = Up; dir <= Right; ++dir) {
+        int next = cell + NEIGHBOR_OFFSETS[dir];
+        // Not attacked (the border never is); the queue skips cells it already holds
+        if (target.isUntriedAt(next)) {
+            possibleMoves.pushBack(next);
+        }
+    }
+}
+
+bool BotPlayer::hardShot(const Board &target, int &row, int &col) {
+    if (lastHits.isEmpty()) {
+        // If no recent hits, use the medium difficulty strategy
+        return smartShot(target, row, col);
+    }
+
+    while (!lastHits.isEmpty()) {
+        // Continue attacking in the current direction
+        int next = lastHits.back() + NEIGHBOR_OFFSETS[sweep[currentDirection]];
+        if (isWorthShooting(target, next)) {
+            row = paddedRow(next);
+            col = paddedCol(next);
+            pendingMove = SweepMove;
+            return true;
+        }
+
+        // If the current direction is invalid, try the next direction; once
+        // all are tried, start from the previous hit
+        currentDirection = (currentDirection + 1) % 4;
+        if (currentDirection == 0) lastHits.popBack();
+    }
+
+    // If no more hits to work from, go back to hunting
+    pendingMove = RestartMove;
+    return huntShot(target, row, col);
+}
+
+bool BotPlayer::expertShot(const Board &target, int &row, int &col) {
+    while (!expertTargets.isEmpty()) {
+        // Most likely ship cell next to the hits so far
+        int cell = expertTargets.pop();
+        // Scores can be stale; a cell no open hit reaches is not a target
+        if (!isWorthShooting(target, cell) || expertScore(target, cell) == 0) continue;
+        row = paddedRow(cell);
+        col = paddedCol(cell);
+        return true;
+    }
+
+    // Hunt on the parity lattice until a ship is hit
+    return huntShot(target, row, col);
+}
+
+// Weight of the ship positions through an untried cell that touch at least
+// one unsunk hit: each such position of each ship afloat adds its hit count.
+// Misses, sunk ships and the border rule positions out.
+int BotPlayer::expertScore(const Board &target, int cell) const {
+    const Fleet &fleet = target.fleet();
+    int score = 0;
+    for (int id = 0; id < fleet.count; ++id) {
+        if (target.isShipSunk(id)) continue;
+        int length = fleet.length[id];
+        for (int step : {1, PADDED_STRIDE}) {
+            // Back up to the earliest start on the board; walks stop at the border
+            int first = cell;
+            for (int i = 1; i < length && target.cellAt(first - step) != SENTINEL; ++i) first -= step;
+            for (int start = first; start <= cell; start += step) {
+                int hits = 0;
+                bool open = true;
+                for (int i = 0, at = start; i < length && open; ++i, at += step) {
+                    char value = target.cellAt(at);
+                    if (value == 'X') {
+                        open = !target.isSunkAt(paddedRow(at), paddedCol(at));
+                        hits++;
+                    } else {
+                        open = target.isUntriedAt(at);
+                    }
+                }
+                if (open) score += hits;
+            }
+        }
+    }
+    return score;
+}
+
+// After a shot at `cell`: queue its untried neighbours if it hit a ship still
+// afloat, then rescore the queued cells on its row and column that a ship
+// could share with it. A sink closes hits anywhere along the ship, so then
+// every queued cell is rescored. Cells no hit can reach any more leave the heap.
+void BotPlayer::rescoreExpertTargets(const Board &target, int cell, const BotShot &shot) {
+    if (shot.sunk) {
+        int queued[PADDED_CELLS];
+        int count = expertTargets.size();
+        for (int i = 0; i < count; ++i) queued[i] = expertTargets.at(i);
+        for (int i = 0; i < count; ++i) {
+            int score = expertScore(target, queued[i]);
+            if (score > 0) expertTargets.update(queued[i], score);
+            else expertTargets.remove(queued[i]);
+        }
+        return;
+    }
+
+    if (shot.hit) {
+        for (int dir = Up; dir <= Right; ++dir) {
+            int next = cell + NEIGHBOR_OFFSETS[dir];
+            if (target.isUntriedAt(next) && !expertTargets.contains(next)) {
+                expertTargets.update(next, expertScore(target, next));
+            }
+        }
+    }
+
+    int reach = 0;
+    const Fleet &fleet = target.fleet();
+    for (int id = 0; id < fleet.count; ++id) reach = qMax(reach, int(fleet.length[id]));
+
+    for (int dir = Up; dir <= Right; ++dir) {
+        int at = cell;
+        for (int i = 1; i < reach; ++i) {
+            at += NEIGHBOR_OFFSETS[dir];
+            if (target.cellAt(at) == SENTINEL) break;
+            if (!expertTargets.contains(at)) continue;
+            int score = expertScore(target, at);
+            if (score > 0) expertTargets.update(at, score);
+            else expertTargets.remove(at);
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef BOTPLAYER_H
+#define BOTPLAYER_H
+
+#include <QVector>
+#include <QString>
+#include "board.h"
+#include "endgame.h"
+#include "opponentprofile.h"
+#include "policytable.h"
+#include "targetheap.h"
+#include "targetqueue.h"
+
+struct BotShot {
+    int row;
+    int col;
+    bool hit;
+    bool sunk;
+};
+
+// Computer opponent, independent of any widgets so it can also run headless.
+class BotPlayer {
+public:
+    enum Difficulty { Easy, Medium, Hard, Expert };
+    static const int DIFFICULTY_COUNT = 4;
+
+    explicit BotPlayer(Difficulty difficulty = Easy);
+
+    static Difficulty difficultyFromName(const QString &name);
+    static const char *difficultyName(Difficulty difficulty);
+    static void placeShips(Board &board, const RuleSet &rules);
+    // Easy places uniformly; the others anneal against a density hunter.
+    void placeFleet(Board &board, const RuleSet &rules) const;
+    // Prior from past games against this opponent, applied from the next game
+    // on: favourite cells are hunted first and, once the profile has enough
+    // games, placement anneals against their shot histogram.
+    void setOpponentProfile(const OpponentProfile &profile, const RuleSet &rules);
+    // Exact policy (ExactSolver) played ahead of the difficulty's own choice
+    // wherever it has an entry for the board.
+    void setPolicyTable(const PolicyTable &table);
+
+    Difficulty difficulty() const;
+    void reset();
+
+    // Takes one turn against the target board. row is -1 if no shot was possible.
+    BotShot attack(Board &target);
+    // attack() in two halves, for targets the bot cannot fire at directly
+    // (an external engine's fleet): chooseShot commits to a cell, and once
+    // the outcome is on the board observe must be called with it.
+    bool chooseShot(const Board &target, int &row, int &col);
+    void observe(const Board &target, const BotShot &shot);
+    // Fires `shots` shots at once (salvo rules), resolved with one attackBatch.
+    SalvoResult attackSalvo(Board &target, int shots);
+    // Whether Expert has the cell queued as a candidate next to its hits
+    bool isTargetQueued(int row, int col) const;
+
+private:
+    // Which branch chose the pending shot, for observe()
+    enum PendingMove { HuntMove, QueuedMove, SweepMove, RestartMove, PolicyMove, EndgameMove, ForcedMove };
+
+    Difficulty level;
+    PendingMove pendingMove;
+    TargetQueue botTargets; // padded ids, like the other queues
+    bool huntingMode;
+    TargetQueue possibleMoves;
+    TargetHeap expertTargets; // Expert's candidates keyed by expertScore
+    TargetQueue lastHits; // used as a stack
+    int currentDirection; // index into the Hard bot's sweep order
+    Direction sweep[4];
+    CellMask favouriteCells; // opponent's favourite ship cells
+    QVector<double> opponentShots; // shot model for placeFleet, empty for the density prior
+    PolicyTable policy;
+    EndgameSolver endgame; // Hard and Expert play exactly once few placements are left
+    CellMask ruledOut; // cells no ship afloat fits over, from the last propagation
+
+    BotShot fire(Board &target, int row, int col);
+    bool isWorthShooting(const Board &target, int cell) const;
+    bool huntShot(const Board &target, int &row, int &col);
+    bool easyShot(const Board &target, int &row, int &col);
+    bool mediumShot(const Board &target, int &row, int &col);
+    bool smartShot(const Board &target, int &row, int &col);
+    bool hardShot(const Board &target, int &row, int &col);
+    bool expertShot(const Board &target, int &row, int &col);
+    int expertScore(const Board &target, int cell) const;
+    void rescoreExpertTargets(const Board &target, int cell, const BotShot &shot);
+    void addAdjacentPositions(const Board &target, int row, int col);
+};
+
+#endif // BOTPLAYER_H
@@ -0,0 +1,164 @@
+#ifndef COMPACTBOARD_H
+#define COMPACTBOARD_H
+
+#include <type_traits>
+#include "board.h"
+
+// Board as a small trivially copyable value, for storing games by the million
+// in contiguous arrays, copying them with memcpy and snapshotting them in a
+// search. Ship cells and untried cells are bit masks of Cells bits and each
+// ship takes four bytes, so CompactBoard<64, 5> (grids up to 8x8) is 40 bytes
+// where a Board is about 700. Plays like Board; bots still take a Board, so
+// convert with toBoard() to hand a game to one.
+template <int Cells = MAX_GRID_CELLS, int Ships = MAX_SHIPS>
+class CompactBoard {
+    static_assert(Cells <= MAX_GRID_CELLS && Ships <= MAX_SHIPS, "larger than any Board");
+
+public:
+    typedef BitMask<Cells> Mask;
+
+    explicit CompactBoard(const RuleSet &rules = RuleSet()) : gridRows(rules.rows), gridCols(rules.cols) {
+        Q_ASSERT(rules.cells() <= Cells);
+        resetBoard();
+    }
+
+    static bool fits(const RuleSet &rules) {
+        return rules.cells() <= Cells && rules.shipCount() <= Ships;
+    }
+
+    // Fleet and shots of a board with a placed fleet
+    static CompactBoard fromBoard(const Board &board) {
+        CompactBoard compact(gridOf(board.rows(), board.cols()));
+        const Fleet &fleet = board.fleet();
+        for (int id = 0; id < fleet.count; ++id) {
+            compact.placeShip(fleet.row[id], fleet.col[id], fleet.vertical[id], fleet.length[id]);
+        }
+        CellMask boardUntried = board.untriedMask();
+        for (int cell = 0; cell < compact.cells(); ++cell) {
+            if (!boardUntried.test(cell)) compact.attack(cell / compact.gridCols, cell % compact.gridCols);
+        }
+        return compact;
+    }
+
+    Board toBoard() const {
+        Board board(gridOf(gridRows, gridCols));
+        for (int id = 0; id < count; ++id) {
+            board.placeShip(start[id] / gridCols, start[id] % gridCols, vertical[id], length[id]);
+        }
+        for (int cell = 0; cell < cells(); ++cell) {
+            if (!untried.test(cell)) board.attack(cell / gridCols, cell % gridCols);
+        }
+        return board;
+    }
+
+    void resetBoard() {
+        shipCells = Mask();
+        untried = Mask::firstBits(cells());
+        count = 0;
+        afloat = 0;
+    }
+
+    bool isValidPosition(int row, int col, bool isVertical, int shipLength) const {
+        if (isVertical ? row + shipLength > gridRows : col + shipLength > gridCols) return false;
+        int step = isVertical ? gridCols : 1;
+        for (int i = 0, cell = row * gridCols + col; i < shipLength; ++i, cell += step) {
+            if (shipCells.test(cell) || !untried.test(cell)) return false;
+        }
+        return true;
+    }
+
+    void placeShip(int row, int col, bool isVertical, int shipLength) {
+        Q_ASSERT(count < Ships);
+        quint8 id = count++;
+        start[id] = row * gridCols + col;
+        length[id] = shipLength;
+        vertical[id] = isVertical;
+        hits[id] = 0;
+        afloat++;
+        int step = isVertical ? gridCols : 1;
+        for (int i = 0; i < shipLength; ++i) shipCells.set(start[id] + i * step);
+    }
+
+    // Same results as Board::attack: a repeated shot never hits
+    bool attack(int row, int col) {
+        int cell = row * gridCols + col;
+        if (!untried.test(cell)) return false;
+        untried.reset(cell);
+        if (!shipCells.test(cell)) return false;
+        int id = shipAt(row, col);
+        if (++hits[id] == length[id]) afloat--;
+        return true;
+    }
+
+    bool hasShipsRemaining() const { return afloat > 0; }
+
+    char getCell(int row, int col) const {
+        int cell = row * gridCols + col;
+        if (shipCells.test(cell)) return untried.test(cell) ? 'S' : 'X';
+        return untried.test(cell) ? '~' : 'O';
+    }
+
+    Mask untriedMask() const { return untried; }
+
+    int smallestShipRemaining() const {
+        int smallest = 0;
+        for (int id = 0; id < count; ++id) {
+            if (hits[id] < length[id] && (smallest == 0 || length[id] < smallest)) smallest = length[id];
+        }
+        return smallest;
+    }
+
+    // Ship id covering the cell, or -1 for open water. A walk over the fleet
+    // instead of Board's cell table, which is most of Board's size.
+    int shipAt(int row, int col) const {
+        int cell = row * gridCols + col;
+        if (!shipCells.test(cell)) return -1;
+        for (int id = 0; id < count; ++id) {
+            int offset = cell - start[id];
+            if (offset < 0) continue;
+            if (vertical[id] ? offset % gridCols == 0 && offset / gridCols < length[id] : offset < length[id]) return id;
+        }
+        return -1;
+    }
+
+    bool isShipSunk(int shipId) const { return hits[shipId] == length[shipId]; }
+
+    bool isSunkAt(int row, int col) const {
+        int id = shipAt(row, col);
+        return id >= 0 && isShipSunk(id);
+    }
+
+    int shipsAfloat() const { return afloat; }
+    int rows() const { return gridRows; }
+    int cols() const { return gridCols; }
+    int cells() const { return gridRows * gridCols; }
+    bool isInside(int row, int col) const { return row >= 0 && row < gridRows && col >= 0 && col < gridCols; }
+
+private:
+    Mask shipCells;
+    Mask untried;
+    quint8 gridRows;
+    quint8 gridCols;
+    quint8 count;
+    quint8 afloat;
+    quint8 start[Ships]; // row * cols + col of the ship's first cell
+    quint8 length[Ships];
+    quint8 hits[Ships];
+    bool vertical[Ships];
+
+    static RuleSet gridOf(int rows, int cols) {
+        RuleSet grid;
+        grid.rows = rows;
+        grid.cols = cols;
+        return grid;
+    }
+};
+
+// Grids up to 8x8 with at most five ships, e.g. the 7x7 default
+typedef CompactBoard<64, 5> SmallCompactBoard;
+
+static_assert(std::is_trivially_copyable<SmallCompactBoard>::value, "compact boards are copied with memcpy");
+static_assert(std::is_trivially_copyable<CompactBoard<>>::value, "compact boards are copied with memcpy");
+static_assert(sizeof(SmallCompactBoard) == 40, "a small game should stay 40 bytes");
+
+#endif // COMPACTBOARD_H
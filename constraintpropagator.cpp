@@ -0,0 +1,113 @@
+#include "constraintpropagator.h"
+#include "latencyprobe.h"
+
+namespace {
+
+// Cells where a ship of each length fits inside the grid, as the start of a
+// row-wise or a column-wise run
+struct StartTable {
+    int rows = 0;
+    int cols = 0;
+    CellMask horizontal[MAX_GRID_SIZE + 1];
+    CellMask vertical[MAX_GRID_SIZE + 1];
+
+    void build(int newRows, int newCols) {
+        rows = newRows;
+        cols = newCols;
+        for (int length = 1; length <= MAX_GRID_SIZE; ++length) {
+            horizontal[length] = CellMask();
+            vertical[length] = CellMask();
+            for (int row = 0; row < rows; ++row) {
+                for (int col = 0; col < cols; ++col) {
+                    if (col + length <= cols) horizontal[length].set(row * cols + col);
+                    if (row + length <= rows) vertical[length].set(row * cols + col);
+                }
+            }
+        }
+    }
+};
+
+// Rebuilt only when the grid shape changes, i.e. once per rule set
+const StartTable &startTable(int rows, int cols) {
+    static thread_local StartTable table;
+    if (table.rows != rows || table.cols != cols) table.build(rows, cols);
+    return table;
+}
+
+// Starts of the runs of `length` cells, `step` apart, that lie inside `room`
+CellMask fittingStarts(const CellMask &room, const CellMask &inGrid, int length, int step) {
+    CellMask starts = inGrid;
+    for (int i = 0; i < length && !starts.isEmpty(); ++i) starts &= room >> (i * step);
+    return starts;
+}
+
+CellMask coveredBy(const CellMask &starts, int length, int step) {
+    CellMask cells;
+    for (int i = 0; i < length; ++i) cells |= starts << (i * step);
+    return cells;
+}
+
+}
+
+ForcedCells ConstraintPropagator::propagate(const Board &target) {
+    LATENCY_PROBE("bot.propagate");
+    int cols = target.cols();
+    const StartTable &table = startTable(target.rows(), cols);
+
+    // Sunk ships are fixed water for the rest; every other hit is open
+    const Fleet &fleet = target.fleet();
+    CellMask sunk;
+    bool afloat[MAX_GRID_SIZE + 1] = {};
+    for (int id = 0; id < fleet.count; ++id) {
+        int length = fleet.length[id];
+        if (!target.isShipSunk(id)) {
+            afloat[length] = true;
+            continue;
+        }
+        int step = fleet.vertical[id] ? cols : 1;
+        for (int i = 0, cell = fleet.row[id] * cols + fleet.col[id]; i < length; ++i, cell += step) sunk.set(cell);
+    }
+    CellMask untried = target.untriedMask();
+    CellMask openHits = target.hitMask() & ~sunk;
+    CellMask room = untried | openHits;
+
+    CellMask starts[2][MAX_GRID_SIZE + 1];
+    CellMask covered;
+    for (int length = 1; length <= MAX_GRID_SIZE; ++length) {
+        if (!afloat[length]) continue;
+        starts[0][length] = fittingStarts(room, table.horizontal[length], length, 1);
+        starts[1][length] = fittingStarts(room, table.vertical[length], length, cols);
+        covered |= coveredBy(starts[0][length], length, 1) | coveredBy(starts[1][length], length, cols);
+    }
+
+    ForcedCells forced;
+    forced.empty = untried & ~covered;
+
+    // Few open hits at any time, so their positions are walked one by one
+    for (int w = 0; w < CellMask::WORDS; ++w) {
+        quint64 word = openHits.words[w];
+        while (word) {
+            int hit = w * 64 + qCountTrailingZeroBits(word);
+            word &= word - 1;
+            CellMask common = CellMask::full();
+            bool fits = false;
+            for (int length = 1; length <= MAX_GRID_SIZE; ++length) {
+                if (!afloat[length]) continue;
+                for (int vertical = 0; vertical < 2; ++vertical) {
+                    int step = vertical ? cols : 1;
+                    // A start in the table keeps its run on one row, so no wrap check
+                    for (int i = 0, start = hit; i < length && start >= 0; ++i, start -= step) {
+                        if (!starts[vertical][length].test(start)) continue;
+                        CellMask cells;
+                        for (int k = 0; k < length; ++k) cells.set(start + k * step);
+                        common &= cells;
+                        fits = true;
+                    }
+                }
+            }
+            if (fits) forced.ship |= common;
+        }
+    }
+    forced.ship &= untried;
+    return forced;
+}
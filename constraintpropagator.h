@@ -0,0 +1,24 @@
+#ifndef CONSTRAINTPROPAGATOR_H
+#define CONSTRAINTPROPAGATOR_H
+
+#include "board.h"
+
+// Untried cells the shot results so far already decide.
+struct ForcedCells {
+    CellMask empty; // no ship afloat fits over the cell: never worth a shot
+    CellMask ship;  // every ship that could cover some open hit covers it: a sure hit
+};
+
+// Minesweeper-style deductions over bit masks. A ship of length L fits where
+// L consecutive cells are untried or open hits, found by ANDing the room mask
+// shifted along the row (or column) L times, and ORing the fits back out
+// gives every cell some ship afloat can still cover. A gap shorter than the
+// smallest ship afloat drops out on its own. An open hit belongs to a ship
+// afloat, so the cells shared by all its fitting positions are ship cells,
+// e.g. the one way a hit can still extend.
+class ConstraintPropagator {
+public:
+    static ForcedCells propagate(const Board &target);
+};
+
+#endif // CONSTRAINTPROPAGATOR_H
@@ -0,0 +1,274 @@
+#include "endgame.h"
+#include "latencyprobe.h"
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+EndgameSolver::EndgameSolver(int limit)
+    : limit(qBound(1, limit, 64)), gridRows(0), gridCols(0), nodes(0), searched(0)
+{
+}
+
+bool EndgameSolver::enumerate(const Board &target) {
+    LATENCY_PROBE("bot.endgame.enumerate");
+    if (target.rows() != gridRows || target.cols() != gridCols) {
+        gridRows = target.rows();
+        gridCols = target.cols();
+        RuleSet grid;
+        grid.rows = gridRows;
+        grid.cols = gridCols;
+        int longest = qMax(gridRows, gridCols);
+        positions = QVector<QVector<CellMask>>(longest + 1);
+        positionsThrough = QVector<QVector<QVector<int>>>(longest + 1, QVector<QVector<int>>(grid.cells()));
+        for (int length = 1; length <= longest; ++length) {
+            positions[length] = shipPositions(grid, length);
+            for (int i = 0; i < positions[length].size(); ++i) {
+                for (int cell = 0; cell < grid.cells(); ++cell) {
+                    if (positions[length][i].test(cell)) positionsThrough[length][cell].append(i);
+                }
+            }
+        }
+    }
+
+    // Only what the shooter has seen: tried cells, and which ships are sunk
+    CellMask untried = target.untriedMask();
+    blocked = CellMask();
+    openHits = CellMask();
+    for (int cell = 0; cell < target.cells(); ++cell) {
+        if (untried.test(cell)) continue;
+        int row = cell / gridCols;
+        int col = cell % gridCols;
+        if (target.shipAt(row, col) >= 0 && !target.isSunkAt(row, col)) openHits.set(cell);
+        else blocked.set(cell);
+    }
+
+    lengths.clear();
+    const Fleet &fleet = target.fleet();
+    for (int id = 0; id < fleet.count; ++id) {
+        if (!target.isShipSunk(id)) lengths.append(fleet.length[id]);
+    }
+    std::sort(lengths.begin(), lengths.end(), std::greater<int>());
+
+    shipCells.clear();
+    placementCells.clear();
+    current.resize(lengths.size());
+    placed = QVector<bool>(lengths.size(), false);
+    nodes = 0;
+    if (lengths.isEmpty() || !place(CellMask(), 0)) {
+        shipCells.clear();
+        placementCells.clear();
+        return false;
+    }
+    return !placementCells.isEmpty();
+}
+
+int EndgameSolver::placements() const {
+    return placementCells.size();
+}
+
+// Open hits are covered first, lowest cell first: some ship afloat has to
+// take each, and trying one ship of every length for it lists each placement
+// once. The ships left then go on untried water, equal lengths in increasing
+// position order. False once the limit or the node budget is exceeded.
+bool EndgameSolver::place(const CellMask &used, int firstPosition) {
+    if (++nodes > NODE_BUDGET) return false;
+
+    CellMask uncovered = openHits & ~used;
+    if (!uncovered.isEmpty()) {
+        int room = 0;
+        for (int i = 0; i < lengths.size(); ++i) room += placed[i] ? 0 : lengths[i];
+        if (uncovered.count() > room) return true;
+
+        int hit = uncovered.select(0);
+        for (int ship = 0; ship < lengths.size(); ++ship) {
+            if (placed[ship] || (ship > 0 && lengths[ship] == lengths[ship - 1] && !placed[ship - 1])) continue;
+            for (int i : positionsThrough[lengths[ship]][hit]) {
+                const CellMask &cells = positions[lengths[ship]][i];
+                if (!fits(cells, used)) continue;
+                placed[ship] = true;
+                current[ship] = cells;
+                bool more = place(used | cells, 0);
+                placed[ship] = false;
+                if (!more) return false;
+            }
+        }
+        return true;
+    }
+
+    int ship = 0;
+    while (ship < lengths.size() && placed[ship]) ++ship;
+    if (ship == lengths.size()) {
+        if (placementCells.size() == limit) return false;
+        for (const CellMask &cells : current) shipCells.append(cells);
+        placementCells.append(used);
+        return true;
+    }
+
+    int next = ship + 1;
+    while (next < lengths.size() && placed[next]) ++next;
+    bool sameLength = next < lengths.size() && lengths[next] == lengths[ship];
+    const QVector<CellMask> &masks = positions[lengths[ship]];
+    placed[ship] = true;
+    for (int i = firstPosition; i < masks.size(); ++i) {
+        if (!fits(masks[i], used)) continue;
+        current[ship] = masks[i];
+        if (!place(used | masks[i], sameLength ? i + 1 : 0)) {
+            placed[ship] = false;
+            return false;
+        }
+    }
+    placed[ship] = false;
+    return true;
+}
+
+// Clear of misses, sunk ships and the ships placed so far, and not made of
+// open hits alone: that ship would have been sunk.
+bool EndgameSolver::fits(const CellMask &cells, const CellMask &used) const {
+    return (cells & (blocked | used)).isEmpty() && !(cells & ~openHits).isEmpty();
+}
+
+bool EndgameSolver::chooseShot(int &row, int &col, double *expected) {
+    LATENCY_PROBE("bot.endgame.solve");
+    if (placementCells.isEmpty()) return false;
+    quint64 all = placementCells.size() == 64 ? ~quint64(0) : (quint64(1) << placementCells.size()) - 1;
+    memo.clear();
+    searched = 0;
+    int cell = -1;
+    double value = solve(all, openHits, std::numeric_limits<double>::infinity(), &cell);
+    memo.clear();
+    if (cell < 0 || searched > SEARCH_BUDGET) return false;
+    row = cell / gridCols;
+    col = cell % gridCols;
+    if (expected) *expected = value;
+    return true;
+}
+
+// Expected shots to finish from here: exact below bound, otherwise a lower
+// bound of at least bound.
+double EndgameSolver::solve(quint64 placementSet, const CellMask &fired, double bound, int *bestCell) {
+    double least = leastShots(placementSet, fired);
+    if (least == 0 || ++searched > SEARCH_BUDGET) return least;
+    if (!(placementSet & (placementSet - 1))) {
+        // One placement left: fire at its cells
+        if (bestCell) *bestCell = (placementCells[qCountTrailingZeroBits(placementSet)] & ~fired).select(0);
+        return least;
+    }
+
+    CellMask relevant;
+    for (quint64 set = placementSet; set; set &= set - 1) relevant |= placementCells[qCountTrailingZeroBits(set)];
+    EndgameKey key = {placementSet, fired & relevant};
+    if (!bestCell) {
+        auto known = memo.constFind(key);
+        if (known != memo.constEnd()) return *known;
+    }
+
+    double leastMisses;
+    QVector<int> cells = candidates(placementSet, fired, &leastMisses);
+    if (least + leastMisses >= bound) return least + leastMisses;
+
+    double total = qPopulationCount(placementSet);
+    double best = std::numeric_limits<double>::infinity();
+    for (int cell : cells) {
+        double limitForShot = qMin(bound, best);
+        QVector<Outcome> results = outcomes(placementSet, fired, cell);
+        CellMask after = fired;
+        after.set(cell);
+
+        double value = 1;
+        for (const Outcome &outcome : results) {
+            value += qPopulationCount(outcome.placements) / total * leastShots(outcome.placements, after);
+        }
+        for (const Outcome &outcome : results) {
+            if (value >= limitForShot) break;
+            double weight = qPopulationCount(outcome.placements) / total;
+            double floor = leastShots(outcome.placements, after);
+            double budget = floor + (limitForShot - value) / weight;
+            value += weight * (solve(outcome.placements, after, budget, nullptr) - floor);
+        }
+        if (value < best) {
+            best = value;
+            if (bestCell) *bestCell = cell;
+        }
+    }
+    if (best < bound) memo.insert(key, best);
+    return best;
+}
+
+// Cells some placement left covers, likeliest first; a cell all of them
+// cover is the only candidate. leastMisses bounds the misses to come: k
+// shots can hit at most the placements covering the k most covered cells.
+QVector<int> EndgameSolver::candidates(quint64 placementSet, const CellMask &fired, double *leastMisses) const {
+    QVector<int> coverage(gridRows * gridCols, 0);
+    int total = qPopulationCount(placementSet);
+    for (quint64 set = placementSet; set; set &= set - 1) {
+        CellMask open = placementCells[qCountTrailingZeroBits(set)] & ~fired;
+        for (int w = 0; w < CellMask::WORDS; ++w) {
+            for (quint64 word = open.words[w]; word; word &= word - 1) coverage[w * 64 + qCountTrailingZeroBits(word)]++;
+        }
+    }
+
+    QVector<int> cells;
+    for (int cell = 0; cell < coverage.size(); ++cell) {
+        if (coverage[cell] == total) {
+            *leastMisses = 0;
+            return QVector<int>{cell};
+        }
+        if (coverage[cell] > 0) cells.append(cell);
+    }
+    std::stable_sort(cells.begin(), cells.end(), [&coverage](int a, int b) { return coverage[a] > coverage[b]; });
+
+    *leastMisses = 0;
+    int reached = 0;
+    for (int cell : cells) {
+        reached += coverage[cell];
+        if (reached >= total) break;
+        *leastMisses += 1 - double(reached) / total;
+    }
+    return cells;
+}
+
+// Placements grouped by what a shot at `cell` would show: a miss, a hit, or
+// the cells of the ship it sinks.
+QVector<EndgameSolver::Outcome> EndgameSolver::outcomes(quint64 placementSet, const CellMask &fired, int cell) const {
+    QVector<Outcome> results;
+    results.append(Outcome{0, CellMask()}); // miss
+    results.append(Outcome{0, CellMask()}); // hit
+    int ships = lengths.size();
+    for (quint64 set = placementSet; set; set &= set - 1) {
+        int p = qCountTrailingZeroBits(set);
+        quint64 bit = quint64(1) << p;
+        if (!placementCells[p].test(cell)) {
+            results[0].placements |= bit;
+            continue;
+        }
+        CellMask ship;
+        for (int i = 0; i < ships; ++i) {
+            if (shipCells[p * ships + i].test(cell)) ship = shipCells[p * ships + i];
+        }
+        CellMask left = ship & ~fired;
+        left.reset(cell);
+        if (!left.isEmpty()) {
+            results[1].placements |= bit;
+            continue;
+        }
+        int at = 2;
+        while (at < results.size() && results[at].sunk != ship) ++at;
+        if (at == results.size()) results.append(Outcome{0, ship});
+        results[at].placements |= bit;
+    }
+    results.erase(std::remove_if(results.begin(), results.end(), [](const Outcome &outcome) {
+        return outcome.placements == 0;
+    }), results.end());
+    return results;
+}
+
+// Average unfired ship cells over the placements: every one takes a shot.
+double EndgameSolver::leastShots(quint64 placementSet, const CellMask &fired) const {
+    int cells = 0;
+    int count = 0;
+    for (quint64 set = placementSet; set; set &= set - 1) {
+        cells += (placementCells[qCountTrailingZeroBits(set)] & ~fired).count();
+        count++;
+    }
+    return count ? double(cells) / count : 0;
+}
@@ -0,0 +1,78 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <QHash>
+#include <QVector>
+#include "board.h"
+
+// Memo key of EndgameSolver: placements left, and the cells among theirs
+// fired at so far.
+struct EndgameKey {
+    quint64 placements;
+    CellMask fired;
+
+    bool operator==(const EndgameKey &other) const {
+        return placements == other.placements && fired == other.fired;
+    }
+};
+
+inline size_t qHash(const EndgameKey &key, size_t seed = 0) {
+    quint64 mixed = key.placements * 0x9E3779B97F4A7C15ull;
+    for (int w = 0; w < CellMask::WORDS; ++w) mixed = (mixed ^ key.fired.words[w]) * 0xC2B2AE3D27D4EB4Full;
+    return size_t(mixed ^ (mixed >> 31)) ^ seed;
+}
+
+// Exact play for the end of a game. When few placements of the ships still
+// afloat fit what the shooter has seen, they are listed by backtracking over
+// position masks, and the shot is the one with the least expected shots to
+// finish: expectimax over the listed placements, memoized on which of them
+// are left and which of their cells have been fired at.
+class EndgameSolver {
+public:
+    // Placements are tracked as a 64-bit set, so the limit is at most 64
+    static const int DEFAULT_LIMIT = 32;
+    // Backtracking steps enumerate() may take, and states chooseShot() may
+    // search, before giving the move back to the heuristics
+    static const int NODE_BUDGET = 5000;
+    static const int SEARCH_BUDGET = 1000;
+
+    explicit EndgameSolver(int limit = DEFAULT_LIMIT);
+
+    // False, with nothing listed, if more than the limit fit the board.
+    bool enumerate(const Board &target);
+    int placements() const;
+    // Best shot over what the last successful enumerate() listed; false if
+    // the search does not fit its budget.
+    bool chooseShot(int &row, int &col, double *expected = nullptr);
+
+private:
+    struct Outcome {
+        quint64 placements;
+        CellMask sunk; // cells of the ship this shot sinks, if any
+    };
+
+    int limit;
+    int gridRows;
+    int gridCols;
+    QVector<QVector<CellMask>> positions; // [length] for the current grid
+    QVector<QVector<QVector<int>>> positionsThrough; // [length][cell]: indices into positions[length]
+    QVector<int> lengths; // ships afloat, longest first
+    CellMask blocked; // misses and sunk ships
+    CellMask openHits; // hits on ships afloat, fired in every placement
+    QVector<CellMask> shipCells; // placement p's ship i at p * lengths.size() + i
+    QVector<CellMask> placementCells;
+    QVector<CellMask> current;
+    QVector<bool> placed;
+    int nodes;
+    int searched;
+    QHash<EndgameKey, double> memo; // exact values, for one chooseShot()
+
+    bool place(const CellMask &used, int firstPosition);
+    bool fits(const CellMask &cells, const CellMask &used) const;
+    double solve(quint64 placementSet, const CellMask &fired, double bound, int *bestCell);
+    QVector<int> candidates(quint64 placementSet, const CellMask &fired, double *leastMisses) const;
+    QVector<Outcome> outcomes(quint64 placementSet, const CellMask &fired, int cell) const;
+    double leastShots(quint64 placementSet, const CellMask &fired) const;
+};
+
+#endif // ENDGAME_H
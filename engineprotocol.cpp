@@ -0,0 +1,234 @@
+#include "engineprotocol.h"
+#include "latencyprobe.h"
+#include "tracing.h"
+#include <QStringList>
+
+QString EngineProtocol::cellName(int row, int col) {
+    return QString("%1%2").arg(QChar('A' + col)).arg(row + 1);
+}
+
+bool EngineProtocol::parseCell(const QString &text, const RuleSet &rules, int &row, int &col) {
+    if (text.size() < 2) return false;
+    col = text.at(0).toUpper().unicode() - 'A';
+    bool ok = false;
+    row = text.mid(1).toInt(&ok) - 1;
+    return ok && row >= 0 && row < rules.rows && col >= 0 && col < rules.cols;
+}
+
+ProtocolEngine::ProtocolEngine(BotPlayer::Difficulty difficulty)
+    : bot(difficulty), hasGame(false), finished(false), pendingRow(-1), pendingCol(-1)
+{
+}
+
+QString ProtocolEngine::handle(const QString &line) {
+    QStringList words = line.simplified().split(' ');
+    QString command = words.value(0);
+
+    if (command.isEmpty()) {
+        return QString();
+    } else if (command == "name") {
+        return QString("name %1 bot").arg(BotPlayer::difficultyName(bot.difficulty()));
+    } else if (command == "quit") {
+        finished = true;
+        return QString();
+    } else if (command == "newgame") {
+        bool ok = false;
+        RuleSet parsed = RuleSet::parse(words.value(1), &ok);
+        if (!ok) return "error invalid rules";
+        if (parsed.isSalvo()) return "error salvo rules are not supported";
+        rules = parsed;
+        target = Board::unknownFleet(rules);
+        bot.reset();
+        hasGame = true;
+        pendingRow = -1;
+        return "ok";
+    }
+
+    if (!hasGame) return "error no game";
+    if (command == "place") {
+        Board own(rules);
+        bot.placeFleet(own, rules);
+        QString reply = "fleet";
+        const Fleet &fleet = own.fleet();
+        for (int id = 0; id < fleet.count; ++id) {
+            reply += " " + EngineProtocol::cellName(fleet.row[id], fleet.col[id]) + (fleet.vertical[id] ? "v" : "h");
+        }
+        return reply;
+    } else if (command == "shot?") {
+        // Asking again before the result repeats the pending shot
+        if (pendingRow < 0 && !bot.chooseShot(target, pendingRow, pendingCol)) {
+            pendingRow = -1;
+            return "error no untried cells";
+        }
+        return "shot " + EngineProtocol::cellName(pendingRow, pendingCol);
+    } else if (command == "result") {
+        int row, col;
+        QString outcome = words.value(2);
+        if (!EngineProtocol::parseCell(words.value(1), rules, row, col)
+            || (outcome != "hit" && outcome != "miss" && outcome != "sunk")) {
+            qWarning("engine: bad result line \"%s\"", qPrintable(line));
+            return QString();
+        }
+        if (outcome == "miss") target.recordMiss(row, col);
+        else if (outcome == "hit") target.recordHit(row, col);
+        else if (!target.recordSunk(row, col, words.value(3).toInt())) {
+            qWarning("engine: no ship afloat fits \"%s\"", qPrintable(line));
+        }
+        if (row == pendingRow && col == pendingCol) {
+            BotShot shot = {row, col, outcome != "miss", outcome == "sunk"};
+            bot.observe(target, shot);
+            pendingRow = -1;
+        }
+        return QString();
+    }
+    return "error unknown command " + command;
+}
+
+bool ProtocolEngine::isFinished() const {
+    return finished;
+}
+
+ExternalEngine::ExternalEngine(const QString &command, int timeoutMs) : command(command), timeout(timeoutMs) {
+}
+
+ExternalEngine::~ExternalEngine() {
+    if (process.state() == QProcess::NotRunning) return;
+    send("quit");
+    process.closeWriteChannel();
+    if (!process.waitForFinished(timeout)) process.kill();
+}
+
+bool ExternalEngine::start() {
+    QStringList arguments = QProcess::splitCommand(command);
+    if (arguments.isEmpty()) return fail("empty engine command");
+    QString program = arguments.takeFirst();
+    process.start(program, arguments);
+    if (!process.waitForStarted(timeout)) return fail("could not start " + program);
+
+    QString reply;
+    if (!send("name") || !receive(reply)) return false;
+    if (!reply.startsWith("name ")) return fail("expected name, got \"" + reply + "\"");
+    engineName = reply.mid(5);
+    return true;
+}
+
+QString ExternalEngine::name() const {
+    return engineName;
+}
+
+QString ExternalEngine::error() const {
+    return lastError;
+}
+
+bool ExternalEngine::newGame(const RuleSet &newRules) {
+    rules = newRules;
+    QString reply;
+    if (!send("newgame " + rules.toString()) || !receive(reply)) return false;
+    return reply == "ok" || fail("newgame refused: " + reply);
+}
+
+// The fleet reply must name every ship of the rules, in order, on legal squares.
+bool ExternalEngine::placeFleet(Board &board) {
+    QString reply;
+    if (!send("place") || !receive(reply)) return false;
+    QStringList words = reply.split(' ');
+    if (words.value(0) != "fleet" || words.size() != rules.shipCount() + 1) {
+        return fail("bad fleet \"" + reply + "\"");
+    }
+    for (int i = 0; i < rules.shipCount(); ++i) {
+        QString ship = words[i + 1];
+        int row, col;
+        bool isVertical = ship.endsWith('v');
+        if ((!isVertical && !ship.endsWith('h')) || !EngineProtocol::parseCell(ship.left(ship.size() - 1), rules, row, col)
+            || !board.isValidPosition(row, col, isVertical, rules.shipLengths[i])) {
+            return fail("illegal ship \"" + ship + "\"");
+        }
+        board.placeShip(row, col, isVertical, rules.shipLengths[i]);
+    }
+    return true;
+}
+
+bool ExternalEngine::nextShot(const Board &target, int &row, int &col) {
+    LATENCY_PROBE("engine.reply");
+    TRACE_SPAN("engine", "reply");
+    QString reply;
+    if (!send("shot?") || !receive(reply)) return false;
+    if (!reply.startsWith("shot ") || !EngineProtocol::parseCell(reply.mid(5), rules, row, col)) {
+        return fail("bad shot \"" + reply + "\"");
+    }
+    if (!target.isUntriedAt(paddedCell(row, col))) return fail("repeated shot " + reply.mid(5));
+    return true;
+}
+
+bool ExternalEngine::sendResult(const BotShot &shot, int sunkLength) {
+    QString cell = EngineProtocol::cellName(shot.row, shot.col);
+    if (shot.sunk) return send(QString("result %1 sunk %2").arg(cell).arg(sunkLength));
+    return send(QString("result %1 %2").arg(cell, shot.hit ? "hit" : "miss"));
+}
+
+bool ExternalEngine::send(const QString &line) {
+    QByteArray bytes = line.toUtf8() + '\n';
+    if (process.write(bytes) != bytes.size()) return fail("engine closed its input");
+    return true;
+}
+
+bool ExternalEngine::receive(QString &line) {
+    while (!process.canReadLine()) {
+        if (process.state() == QProcess::NotRunning) return fail("engine exited");
+        if (!process.waitForReadyRead(timeout)) return fail("engine timed out");
+    }
+    line = QString::fromUtf8(process.readLine()).trimmed();
+    return true;
+}
+
+bool ExternalEngine::fail(const QString &reason) {
+    lastError = reason;
+    return false;
+}
+
+MatchResult playExternalMatch(ExternalEngine &engine, BotPlayer &bot, const RuleSet &rules, bool engineFirst) {
+    Board boards[2] = {Board(rules), Board(rules)}; // boards[side] holds that side's fleet
+    MatchResult result = {-1, {0, 0}, {-1, -1}};
+
+    if (!engine.newGame(rules) || !engine.placeFleet(boards[0])) {
+        result.winner = 1;
+        return result;
+    }
+    bot.placeFleet(boards[1], rules);
+    bot.reset();
+
+    for (int turn = 0; turn < 2 * rules.cells(); ++turn) {
+        int side = (turn + (engineFirst ? 0 : 1)) % 2;
+        Board &target = boards[1 - side];
+        BotShot shot;
+        if (side == 0) {
+            int row, col;
+            if (!engine.nextShot(target, row, col)) {
+                result.winner = 1;
+                break;
+            }
+            shot.row = row;
+            shot.col = col;
+            shot.hit = target.attack(row, col);
+            shot.sunk = shot.hit && target.isSunkAt(row, col);
+            int sunkLength = shot.sunk ? target.fleet().length[target.shipAt(row, col)] : 0;
+            if (!engine.sendResult(shot, sunkLength)) {
+                result.winner = 1;
+                break;
+            }
+        } else {
+            shot = bot.attack(target);
+            if (shot.row < 0) continue;
+        }
+
+        result.shots[side]++;
+        if (shot.hit && result.firstHit[side] < 0) {
+            result.firstHit[side] = shot.row * rules.cols + shot.col;
+        }
+        if (!target.hasShipsRemaining()) {
+            result.winner = side;
+            break;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef ENGINEPROTOCOL_H
+#define ENGINEPROTOCOL_H
+
+#include <QProcess>
+#include <QString>
+#include "board.h"
+#include "botplayer.h"
+#include "simulation.h"
+
+// Line protocol between a match runner and a Battleship engine, in the
+// spirit of UCI/GTP. The runner sends one command per line; replies are one
+// line too:
+//   name                               -> name <text>
+//   newgame <rules>                    -> ok | error <reason>
+//   place                              -> fleet <cell><h|v> ...  (ships in rule order)
+//   shot?                              -> shot <cell>
+//   result <cell> hit|miss|sunk [len]  (no reply)
+//   quit                               (no reply)
+// <rules> is a RuleSet spec as taken by --rules; salvo rules are not part of
+// the protocol. Cells are written as in the GUI: column letter, then the
+// 1-based row ("C7").
+namespace EngineProtocol {
+QString cellName(int row, int col);
+bool parseCell(const QString &text, const RuleSet &rules, int &row, int &col);
+}
+
+// One of our bots behind the protocol (battleship_headless --engine).
+class ProtocolEngine {
+public:
+    explicit ProtocolEngine(BotPlayer::Difficulty difficulty);
+
+    // Reply to one command line, empty for commands without one.
+    QString handle(const QString &line);
+    bool isFinished() const;
+
+private:
+    BotPlayer bot;
+    RuleSet rules;
+    Board target; // the runner's board as learned from results
+    bool hasGame;
+    bool finished;
+    int pendingRow;
+    int pendingCol;
+};
+
+// An external engine process, driven over its stdin and stdout. Every call
+// fails (and error() says why) once the engine breaks the protocol, dies or
+// takes longer than the timeout to reply.
+class ExternalEngine {
+public:
+    static const int DEFAULT_TIMEOUT_MS = 5000;
+
+    explicit ExternalEngine(const QString &command, int timeoutMs = DEFAULT_TIMEOUT_MS);
+    ~ExternalEngine();
+
+    bool start();
+    QString name() const;
+    QString error() const;
+
+    bool newGame(const RuleSet &rules);
+    bool placeFleet(Board &board);
+    bool nextShot(const Board &target, int &row, int &col);
+    bool sendResult(const BotShot &shot, int sunkLength);
+
+private:
+    QString command;
+    int timeout;
+    QProcess process;
+    QString engineName;
+    QString lastError;
+    RuleSet rules;
+
+    bool send(const QString &line);
+    bool receive(QString &line);
+    bool fail(const QString &reason);
+};
+
+// External engine against one of our bots on fresh fleets. Side 0 of the
+// result is the engine; an engine that breaks the protocol forfeits.
+MatchResult playExternalMatch(ExternalEngine &engine, BotPlayer &bot, const RuleSet &rules, bool engineFirst);
+
+#endif // ENGINEPROTOCOL_H
@@ -0,0 +1,47 @@
+#include "enginerandom.h"
+#include <QRandomGenerator>
+#include <atomic>
+
+namespace {
+
+std::atomic<quint32> baseSeed(5489u);
+std::atomic<quint32> generation(0);
+std::atomic<quint32> threadCounter(0);
+
+struct ThreadGenerator {
+    QRandomGenerator generator;
+    quint32 seededGeneration = ~0u;
+};
+
+ThreadGenerator &threadGenerator() {
+    static thread_local ThreadGenerator local;
+    return local;
+}
+
+}
+
+// Reseeds every thread's generator: thread n to draw from seed + n.
+void seedEngineRandom(quint32 seed) {
+    baseSeed.store(seed);
+    threadCounter.store(0);
+    generation.fetch_add(1);
+}
+
+// Worker seeds are spread by the golden ratio so they stay clear of the
+// seed + n of threads seeded in draw order.
+void seedEngineRandomForThread(quint32 worker) {
+    ThreadGenerator &local = threadGenerator();
+    local.generator.seed(baseSeed.load() + 0x9E3779B9u * (worker + 1));
+    local.seededGeneration = generation.load();
+}
+
+// Uniform integer in [0, bound).
+int engineRandom(int bound) {
+    ThreadGenerator &local = threadGenerator();
+    quint32 current = generation.load(std::memory_order_relaxed);
+    if (local.seededGeneration != current) {
+        local.generator.seed(baseSeed.load() + threadCounter.fetch_add(1));
+        local.seededGeneration = current;
+    }
+    return int(local.generator.bounded(quint32(bound)));
+}
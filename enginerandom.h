@@ -0,0 +1,15 @@
+#ifndef ENGINERANDOM_H
+#define ENGINERANDOM_H
+
+#include <QtGlobal>
+
+// Random source for the engine. Each thread owns its generator, so parallel
+// simulations never contend on a shared lock the way rand() does.
+void seedEngineRandom(quint32 seed);
+// Seeds the calling thread from the seed and a worker index. Workers that
+// call this first draw the same numbers on every run, whichever of them
+// starts first; other threads are seeded in the order they first draw.
+void seedEngineRandomForThread(quint32 worker);
+int engineRandom(int bound);
+
+#endif // ENGINERANDOM_H
@@ -0,0 +1,283 @@
+#include "exactsolver.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <vector>
+
+ExactSolver::ExactSolver(const RuleSet &rules)
+    : rules(rules), symmetry(rules.rows, rules.cols), ships(rules.shipCount()), fleetCells(rules.fleetCells()),
+    boardMask(rules.cells() >= 64 ? ~quint64(0) : (quint64(1) << rules.cells()) - 1),
+    threads(qMax(1u, std::thread::hardware_concurrency())), stateLimit(DEFAULT_STATE_LIMIT), rootExpected(0),
+    stateCount(0), aborted(false)
+{
+    Q_ASSERT(isSolvable(rules));
+    for (int length : rules.shipLengths) {
+        QVector<quint64> masks;
+        for (const CellMask &position : shipPositions(rules, length)) masks.append(position.words[0]);
+        positions.append(masks);
+    }
+    QVector<quint64> current(ships);
+    enumerateFleets(0, 0, 0, current);
+}
+
+bool ExactSolver::isSolvable(const RuleSet &rules) {
+    return rules.isValid() && !rules.isSalvo() && rules.cells() <= MAX_CELLS;
+}
+
+void ExactSolver::setThreads(int count) {
+    threads = qMax(1, count);
+}
+
+void ExactSolver::setStateLimit(int states) {
+    stateLimit = states;
+}
+
+// Ships of equal length take increasing positions, so each fleet is listed once
+void ExactSolver::enumerateFleets(int ship, int firstPosition, quint64 used, QVector<quint64> &current) {
+    if (ship == ships) {
+        quint64 all = 0;
+        for (quint64 cells : current) {
+            shipCells.append(cells);
+            all |= cells;
+        }
+        fleetMask.append(all);
+        return;
+    }
+    const QVector<quint64> &masks = positions[ship];
+    for (int i = firstPosition; i < masks.size(); ++i) {
+        if (masks[i] & used) continue;
+        current[ship] = masks[i];
+        bool sameLength = ship + 1 < ships && rules.shipLengths[ship + 1] == rules.shipLengths[ship];
+        enumerateFleets(ship + 1, sameLength ? i + 1 : 0, used | masks[i], current);
+    }
+}
+
+bool ExactSolver::solve() {
+    QVector<int> fleets(fleetMask.size());
+    for (int f = 0; f < fleets.size(); ++f) fleets[f] = f;
+    SolverKey root = {0, 0, 0, 0};
+
+    // Mirror images of a first shot are worth the same
+    QVector<int> shots;
+    for (int cell : candidates(root, fleets)) {
+        bool least = true;
+        for (int s = 1; s < symmetry.count(); ++s) least = least && symmetry.applyToCell(s, cell) >= cell;
+        if (least) shots.append(cell);
+    }
+
+    // Workers share the best first shot so far as their bound
+    QVector<double> values(shots.size());
+    double bestSoFar = std::numeric_limits<double>::infinity();
+    QMutex bestMutex;
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < qMin(threads, int(shots.size())); ++t) {
+        workers.emplace_back([&]() {
+            for (int i = next++; i < shots.size(); i = next++) {
+                bestMutex.lock();
+                double bound = bestSoFar;
+                bestMutex.unlock();
+                values[i] = shotValue(root, fleets, shots[i], bound);
+                QMutexLocker locker(&bestMutex);
+                bestSoFar = qMin(bestSoFar, values[i]);
+            }
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+    if (aborted) return false;
+
+    int best = int(std::min_element(values.begin(), values.end()) - values.begin());
+    rootExpected = values[best];
+    int mapping;
+    SolverKey canonicalRoot = symmetry.canonical(root, mapping);
+    shard(canonicalRoot).entries.insert(canonicalRoot, MemoEntry{rootExpected, quint8(shots[best]), true});
+    return true;
+}
+
+double ExactSolver::expectedShots() const {
+    return rootExpected;
+}
+
+int ExactSolver::fleetCount() const {
+    return fleetMask.size();
+}
+
+int ExactSolver::statesSolved() const {
+    return stateCount;
+}
+
+// Exact value if it is below bound, otherwise a lower bound of at least bound.
+ExactSolver::Value ExactSolver::solveState(const SolverKey &key, const QVector<int> &fleets, double bound) {
+    int remaining = fleetCells - qPopulationCount(key.hits);
+    if (remaining == 0) return Value{0, -1};
+    if (fleets.size() == 1) {
+        quint64 left = fleetMask[fleets[0]] & ~key.hits;
+        return Value{double(remaining), int(qCountTrailingZeroBits(left))};
+    }
+
+    // States with the same consistent fleets are one state: count every cell
+    // no fleet covers as a miss before looking the state up
+    quint64 covered = 0;
+    for (int f : fleets) covered |= fleetMask[f];
+    SolverKey state = {key.hits, boardMask & ~covered, key.sunk, key.sunkShips};
+    int mapping;
+    SolverKey canonicalKey = symmetry.canonical(state, mapping);
+    MemoShard &memo = shard(canonicalKey);
+    {
+        QMutexLocker locker(&memo.mutex);
+        auto entry = memo.entries.constFind(canonicalKey);
+        if (entry != memo.entries.constEnd() && (entry->exact || entry->expected >= bound)) {
+            return Value{entry->expected, entry->exact ? symmetry.invertCell(mapping, entry->cell) : -1};
+        }
+    }
+    if (aborted) return Value{double(remaining), -1};
+
+    double leastMisses;
+    QVector<int> shots = candidates(key, fleets, &leastMisses);
+    double lowerBound = remaining + leastMisses;
+
+    // Each shot has to beat both the caller's bound and the best shot so far
+    Value best = {std::numeric_limits<double>::infinity(), -1};
+    if (lowerBound >= bound) best.expected = lowerBound;
+    for (int cell : lowerBound < bound ? shots : QVector<int>()) {
+        double value = shotValue(key, fleets, cell, qMin(bound, best.expected));
+        if (value < best.expected) best = Value{value, cell};
+    }
+    bool exact = best.expected < bound;
+    if (!exact) best.cell = -1;
+
+    QMutexLocker locker(&memo.mutex);
+    bool added = !memo.entries.contains(canonicalKey);
+    memo.entries.insert(canonicalKey, MemoEntry{best.expected, quint8(exact ? symmetry.applyToCell(mapping, best.cell) : 0),
+                                                exact});
+    if (added && ++stateCount > stateLimit) aborted = true;
+    return best;
+}
+
+// Expected shots after firing at `cell`, or a lower bound of at least bound
+// once it is clear the shot cannot beat it.
+double ExactSolver::shotValue(const SolverKey &key, const QVector<int> &fleets, int cell, double bound) {
+    QVector<Outcome> results = outcomes(key, fleets, cell);
+    std::sort(results.begin(), results.end(), [](const Outcome &a, const Outcome &b) {
+        return a.fleets.size() > b.fleets.size();
+    });
+
+    double total = fleets.size();
+    double lowerBound = 1;
+    for (const Outcome &outcome : results) {
+        lowerBound += outcome.fleets.size() / total * (fleetCells - qPopulationCount(outcome.key.hits));
+    }
+    for (const Outcome &outcome : results) {
+        if (lowerBound >= bound || aborted) return lowerBound;
+        // The most this outcome may cost before the shot stops beating bound
+        double weight = outcome.fleets.size() / total;
+        double least = fleetCells - qPopulationCount(outcome.key.hits);
+        double budget = least + (bound - lowerBound) / weight;
+        lowerBound += weight * (solveState(outcome.key, outcome.fleets, budget).expected - least);
+    }
+    return lowerBound;
+}
+
+// Untried cells some fleet still covers. A cell every fleet covers is the
+// only candidate: it has to be hit eventually, and hitting it now loses nothing.
+// leastMisses is a lower bound on the misses still to come: until the first
+// hit every shot misses, and k shots can hit at most the fleets covering the
+// k most covered cells.
+QVector<int> ExactSolver::candidates(const SolverKey &key, const QVector<int> &fleets, double *leastMisses) const {
+    int coverage[MAX_CELLS] = {};
+    quint64 untried = boardMask & ~(key.hits | key.misses);
+    for (int f : fleets) {
+        quint64 open = fleetMask[f] & untried;
+        while (open) {
+            coverage[qCountTrailingZeroBits(open)]++;
+            open &= open - 1;
+        }
+    }
+
+    QVector<int> cells;
+    for (int cell = 0; cell < rules.cells(); ++cell) {
+        if (coverage[cell] == fleets.size()) {
+            if (leastMisses) *leastMisses = 0;
+            return QVector<int>{cell};
+        }
+        if (coverage[cell] > 0) cells.append(cell);
+    }
+    // Likeliest hits first, so the bound tightens early
+    std::stable_sort(cells.begin(), cells.end(), [&coverage](int a, int b) { return coverage[a] > coverage[b]; });
+    if (leastMisses) {
+        *leastMisses = 0;
+        int reached = 0;
+        for (int cell : cells) {
+            reached += coverage[cell];
+            if (reached >= fleets.size()) break;
+            *leastMisses += 1 - double(reached) / fleets.size();
+        }
+    }
+    return cells;
+}
+
+QVector<ExactSolver::Outcome> ExactSolver::outcomes(const SolverKey &key, const QVector<int> &fleets, int cell) const {
+    quint64 bit = quint64(1) << cell;
+    QVector<Outcome> results;
+    results.append(Outcome{SolverKey{key.hits, key.misses | bit, key.sunk, key.sunkShips}, QVector<int>()});
+    results.append(Outcome{SolverKey{key.hits | bit, key.misses, key.sunk, key.sunkShips}, QVector<int>()});
+
+    for (int f : fleets) {
+        if (!(fleetMask[f] & bit)) {
+            results[0].fleets.append(f);
+            continue;
+        }
+        quint64 ship = 0;
+        int length = 0;
+        for (int i = 0; i < ships && !ship; ++i) {
+            if (shipCells[f * ships + i] & bit) {
+                ship = shipCells[f * ships + i];
+                length = rules.shipLengths[i];
+            }
+        }
+        if (ship & ~(key.hits | bit)) {
+            results[1].fleets.append(f);
+            continue;
+        }
+        // Sinking it shows the shooter which cells and which ship it was
+        quint64 sunk = key.sunk | ship;
+        quint16 sunkShips = SolverKey::markSunk(key.sunkShips, rules.shipLengths, length);
+        int at = 2;
+        while (at < results.size() && (results[at].key.sunk != sunk || results[at].key.sunkShips != sunkShips)) ++at;
+        if (at == results.size()) {
+            results.append(Outcome{SolverKey{key.hits | bit, key.misses, sunk, sunkShips}, QVector<int>()});
+        }
+        results[at].fleets.append(f);
+    }
+
+    results.erase(std::remove_if(results.begin(), results.end(), [](const Outcome &outcome) {
+        return outcome.fleets.isEmpty();
+    }), results.end());
+    return results;
+}
+
+ExactSolver::MemoShard &ExactSolver::shard(const SolverKey &canonicalKey) {
+    return shards[qHash(canonicalKey) % SHARDS];
+}
+
+PolicyTable ExactSolver::policy() {
+    PolicyTable table;
+    table.tableRules = rules;
+    table.symmetry = symmetry;
+    table.expected = rootExpected;
+    QVector<int> fleets(fleetMask.size());
+    for (int f = 0; f < fleets.size(); ++f) fleets[f] = f;
+    collectPolicy(SolverKey{0, 0, 0, 0}, fleets, table);
+    return table;
+}
+
+// Walks every outcome of the optimal shots; mirror images share one entry.
+void ExactSolver::collectPolicy(const SolverKey &key, const QVector<int> &fleets, PolicyTable &table) {
+    Value best = solveState(key, fleets, std::numeric_limits<double>::infinity());
+    if (best.cell < 0) return;
+    int mapping;
+    SolverKey canonicalKey = symmetry.canonical(key, mapping);
+    if (table.moves.contains(canonicalKey)) return;
+    table.moves.insert(canonicalKey, quint8(symmetry.applyToCell(mapping, best.cell)));
+    for (const Outcome &outcome : outcomes(key, fleets, best.cell)) collectPolicy(outcome.key, outcome.fleets, table);
+}
@@ -0,0 +1,88 @@
+#ifndef EXACTSOLVER_H
+#define EXACTSOLVER_H
+
+#include <QHash>
+#include <QMutex>
+#include <QVector>
+#include <atomic>
+#include "policytable.h"
+
+// Minimum expected shots to sink a uniformly placed fleet, by dynamic
+// programming over knowledge states. Each state's consistent fleets are
+// carried down the recursion, values are memoized by canonical key in a
+// sharded table, and the first shot's candidates are solved on parallel
+// threads. Branch and bound passes each state the value it has to beat and
+// memoizes a lower bound when it cannot (a state still needs at least one
+// shot per unhit ship cell).
+//
+// Only practical on small boards: 5x5 with two or three ships, 6x6 or 7x7
+// with a ship or two.
+class ExactSolver {
+public:
+    static const int MAX_CELLS = 64;
+    static const int DEFAULT_STATE_LIMIT = 5000000;
+
+    explicit ExactSolver(const RuleSet &rules);
+    ExactSolver(const ExactSolver &) = delete;
+    ExactSolver &operator=(const ExactSolver &) = delete;
+
+    static bool isSolvable(const RuleSet &rules);
+
+    void setThreads(int threads);
+    // Gives up (solve() returns false) after memoizing this many states
+    void setStateLimit(int states);
+
+    bool solve();
+    double expectedShots() const;
+    int fleetCount() const;
+    int statesSolved() const;
+    // The optimal policy from the empty board, for the bots
+    PolicyTable policy();
+
+private:
+    enum { SHARDS = 64 };
+
+    struct Value {
+        double expected;
+        int cell;
+    };
+    struct MemoEntry {
+        double expected; // exact, or a lower bound when !exact
+        quint8 cell;
+        bool exact;
+    };
+    struct MemoShard {
+        QMutex mutex;
+        QHash<SolverKey, MemoEntry> entries;
+    };
+    // Fleets that give the same result for one shot
+    struct Outcome {
+        SolverKey key;
+        QVector<int> fleets;
+    };
+
+    RuleSet rules;
+    GridSymmetry symmetry;
+    int ships;
+    int fleetCells;
+    quint64 boardMask;
+    QVector<QVector<quint64>> positions; // every position of each ship
+    QVector<quint64> shipCells; // fleet f's ship i at f * ships + i
+    QVector<quint64> fleetMask; // union of fleet f's ships
+    int threads;
+    int stateLimit;
+    double rootExpected;
+    std::atomic<int> stateCount;
+    std::atomic<bool> aborted;
+    MemoShard shards[SHARDS];
+
+    void enumerateFleets(int ship, int firstPosition, quint64 used, QVector<quint64> &current);
+    Value solveState(const SolverKey &key, const QVector<int> &fleets, double bound);
+    double shotValue(const SolverKey &key, const QVector<int> &fleets, int cell, double bound);
+    QVector<int> candidates(const SolverKey &key, const QVector<int> &fleets, double *leastMisses = nullptr) const;
+    QVector<Outcome> outcomes(const SolverKey &key, const QVector<int> &fleets, int cell) const;
+    MemoShard &shard(const SolverKey &canonicalKey);
+    void collectPolicy(const SolverKey &key, const QVector<int> &fleets, PolicyTable &table);
+};
+
+#endif // EXACTSOLVER_H
@@ -0,0 +1,75 @@
+#include "gameevents.h"
+#include "engineprotocol.h"
+
+QString GameEvent::toText() const {
+    static const char *const names[] = {"shot", "hit", "miss", "sunk", "turn", "over"};
+    QString text = QString("game %1 %2 %3").arg(game).arg(names[type]).arg(player);
+    if (type == TurnChanged || type == GameOver) return text;
+    text += " " + EngineProtocol::cellName(row, col);
+    if (type == Sunk) text += QString(" %1").arg(length);
+    return text;
+}
+
+GameEventStream::GameEventStream() : gameNumber(0) {
+}
+
+GameEventStream::~GameEventStream() {
+    qDeleteAll(subscribers);
+}
+
+int GameEventStream::subscribe() {
+    subscribers.append(new Subscriber);
+    return subscribers.size() - 1;
+}
+
+bool GameEventStream::poll(int subscriber, GameEvent &event) {
+    return subscribers.at(subscriber)->queue.pop(event);
+}
+
+quint64 GameEventStream::dropped(int subscriber) const {
+    return subscribers.at(subscriber)->dropped.load(std::memory_order_relaxed);
+}
+
+void GameEventStream::publish(GameEvent::Type type, int player, int row, int col, int length) {
+    GameEvent event = {type, quint8(player), quint8(row), quint8(col), quint8(length), gameNumber};
+    // Const access only (at()): the producer and the consumers share the vector
+    for (int i = 0; i < subscribers.size(); ++i) {
+        Subscriber *subscriber = subscribers.at(i);
+        if (!subscriber->queue.push(event)) subscriber->dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void GameEventStream::newGame() {
+    gameNumber++;
+}
+
+void GameEventStream::shot(int player, const Board &target, int row, int col, bool hit) {
+    publish(GameEvent::ShotFired, player, row, col);
+    publish(hit ? GameEvent::Hit : GameEvent::Miss, player, row, col);
+    if (hit && target.isSunkAt(row, col)) {
+        publish(GameEvent::Sunk, player, row, col, target.fleet().length[target.shipAt(row, col)]);
+    }
+}
+
+void GameEventStream::salvo(int player, const Board &target, const SalvoResult &result) {
+    int cols = target.cols();
+    for (int cell = 0; cell < target.cells(); ++cell) {
+        if (!result.shots.test(cell)) continue;
+        publish(GameEvent::ShotFired, player, cell / cols, cell % cols);
+        publish(result.hits.test(cell) ? GameEvent::Hit : GameEvent::Miss, player, cell / cols, cell % cols);
+    }
+    const Fleet &fleet = target.fleet();
+    for (int id = 0; id < fleet.count; ++id) {
+        if (result.sunk.test(fleet.row[id] * cols + fleet.col[id])) {
+            publish(GameEvent::Sunk, player, fleet.row[id], fleet.col[id], fleet.length[id]);
+        }
+    }
+}
+
+void GameEventStream::turnChanged(int player) {
+    publish(GameEvent::TurnChanged, player);
+}
+
+void GameEventStream::gameOver(int winner) {
+    publish(GameEvent::GameOver, winner);
+}
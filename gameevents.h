@@ -0,0 +1,68 @@
+#ifndef GAMEEVENTS_H
+#define GAMEEVENTS_H
+
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include "board.h"
+#include "spscqueue.h"
+
+// One thing that happened in a game. `player` is the side the event is about:
+// the shooter for shots, the side to move for TurnChanged, the winner for
+// GameOver. Sides are 0 and 1 (the user and the bot in single player).
+struct GameEvent {
+    enum Type : quint8 { ShotFired, Hit, Miss, Sunk, TurnChanged, GameOver };
+
+    Type type;
+    quint8 player;
+    quint8 row;
+    quint8 col;
+    quint8 length; // Sunk: the ship's length
+    quint32 game;  // running game number of the stream
+
+    // "game 3 hit 0 C4", for logs and line-based consumers
+    QString toText() const;
+};
+
+// Typed event stream from the engine to any number of consumers (UI, logs,
+// stats, network). Every subscriber gets its own single-producer
+// single-consumer queue, so the engine publishes with a few stores per
+// subscriber and never waits: if a subscriber falls a whole queue behind,
+// its events are dropped and counted instead. Subscribe before the first
+// event; publish from one thread, and poll each subscriber from one thread.
+class GameEventStream {
+public:
+    static const int QUEUE_CAPACITY = 4096;
+
+    GameEventStream();
+    ~GameEventStream();
+    GameEventStream(const GameEventStream &) = delete;
+    GameEventStream &operator=(const GameEventStream &) = delete;
+
+    int subscribe();
+    bool poll(int subscriber, GameEvent &event);
+    quint64 dropped(int subscriber) const;
+
+    // Producer side
+    void publish(GameEvent::Type type, int player, int row = 0, int col = 0, int length = 0);
+    void newGame();
+    // ShotFired, then Hit or Miss, then Sunk if the shot finished a ship; the
+    // target board is read as the shot left it
+    void shot(int player, const Board &target, int row, int col, bool hit);
+    // The same for every cell of a salvo; each ship it sank is reported once,
+    // at the ship's first cell
+    void salvo(int player, const Board &target, const SalvoResult &result);
+    void turnChanged(int player);
+    void gameOver(int winner);
+
+private:
+    struct Subscriber {
+        SpscQueue<GameEvent, QUEUE_CAPACITY> queue;
+        std::atomic<quint64> dropped{0};
+    };
+
+    QVector<Subscriber *> subscribers;
+    quint32 gameNumber;
+};
+
+#endif // GAMEEVENTS_H
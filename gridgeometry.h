@@ -0,0 +1,49 @@
+#ifndef GRIDGEOMETRY_H
+#define GRIDGEOMETRY_H
+
+#include "ruleset.h"
+
+// Padded cell ids: the grid is stored with a sentinel border (row stride
+// PADDED_STRIDE), so every real cell has four addressable neighbours and a
+// walk stops on a SENTINEL cell instead of testing bounds.
+const int PADDED_STRIDE = MAX_GRID_SIZE + 2;
+const int PADDED_CELLS = PADDED_STRIDE * PADDED_STRIDE;
+const char SENTINEL = '#';
+
+enum Direction { Up, Down, Left, Right };
+constexpr int NEIGHBOR_OFFSETS[4] = {-PADDED_STRIDE, PADDED_STRIDE, -1, 1};
+
+constexpr int paddedCell(int row, int col) {
+    return (row + 1) * PADDED_STRIDE + col + 1;
+}
+
+// Row and column of every padded id, built at compile time so turning a
+// neighbour back into coordinates needs no division. -1 on the outer border.
+struct PaddedCoordinates {
+    int row[PADDED_CELLS];
+    int col[PADDED_CELLS];
+};
+
+constexpr PaddedCoordinates makePaddedCoordinates() {
+    PaddedCoordinates table = {};
+    for (int cell = 0; cell < PADDED_CELLS; ++cell) {
+        int row = cell / PADDED_STRIDE - 1;
+        int col = cell % PADDED_STRIDE - 1;
+        bool inside = row >= 0 && row < MAX_GRID_SIZE && col >= 0 && col < MAX_GRID_SIZE;
+        table.row[cell] = inside ? row : -1;
+        table.col[cell] = inside ? col : -1;
+    }
+    return table;
+}
+
+inline constexpr PaddedCoordinates PADDED_COORDINATES = makePaddedCoordinates();
+
+constexpr int paddedRow(int cell) {
+    return PADDED_COORDINATES.row[cell];
+}
+
+constexpr int paddedCol(int cell) {
+    return PADDED_COORDINATES.col[cell];
+}
+
+#endif // GRIDGEOMETRY_H
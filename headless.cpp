@@ -0,0 +1,549 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <atomic>
+#include <chrono>
+#include <ctime>
+#include <thread>
+#include <vector>
+#include "batchsim.h"
+#include "board.h"
+#include "boardfuzzer.h"
+#include "botplayer.h"
+#include "compactboard.h"
+#include "engineprotocol.h"
+#include "enginerandom.h"
+#include "exactsolver.h"
+#include "gameevents.h"
+#include "latencyprobe.h"
+#include "ratingladder.h"
+#include "simstats.h"
+#include "sparseboard.h"
+#include "tracing.h"
+
+// Headless runner: lets the bots clear randomly placed fleets (or play each
+// other with --matches) without any UI, for latency and strength measurements.
+
+static int playSoloGame(BotPlayer &bot, const RuleSet &rules, GameEventStream *events = nullptr) {
+    Board target(rules);
+    BotPlayer::placeShips(target, rules);
+    bot.reset();
+    if (events) events->newGame();
+
+    int shots = 0;
+    while (target.hasShipsRemaining()) {
+        if (rules.isSalvo()) {
+            // No fleet of its own here, so the bot fires as if all its ships were afloat
+            SalvoResult salvo = bot.attackSalvo(target, rules.shotsPerTurn(rules.shipCount()));
+            int fired = salvo.shots.count();
+            if (fired == 0) break;
+            if (events) events->salvo(0, target, salvo);
+            shots += fired;
+            continue;
+        }
+        BotShot shot = bot.attack(target);
+        if (shot.row < 0) break;
+        if (events) events->shot(0, target, shot.row, shot.col, shot.hit);
+        shots++;
+    }
+    if (events && !target.hasShipsRemaining()) events->gameOver(0);
+    return shots;
+}
+
+// Consumer thread for --event-log: writes the stream's events as lines until
+// `playing` is cleared and the queue is empty.
+static void writeEventLog(GameEventStream &events, int subscriber, QFile &file, const std::atomic<bool> &playing) {
+    QTextStream log(&file);
+    GameEvent event;
+    for (;;) {
+        if (events.poll(subscriber, event)) {
+            log << event.toText() << "\n";
+        } else if (!playing.load(std::memory_order_acquire)) {
+            // Everything published before the flag was cleared is visible now
+            while (events.poll(subscriber, event)) log << event.toText() << "\n";
+            break;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+// Plays every ordered pairing of the difficulties `matches` times, spread over
+// `threads` workers. Each worker fills its own stats and latency histograms;
+// they are merged once at the end, and the results go to `ladder` if given.
+static SimulationStats runMatches(const QVector<BotPlayer::Difficulty> &difficulties, int matches,
+                                  const RuleSet &rules, int threads, RatingLadder *ladder = nullptr) {
+    // Winner of match i of pairing p at i * pairings + p, each written by
+    // exactly one worker
+    int pairings = difficulties.size() * difficulties.size();
+    std::vector<qint8> ladderWinners(ladder ? size_t(matches) * pairings : 0);
+    SimulationStats combined(rules.cells());
+    LatencyRecorder &latency = LatencyRecorder::local();
+    QMutex mergeMutex;
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            // Each worker plays a fixed share of the matches, so with its own
+            // seed a --seed run repeats exactly
+            seedEngineRandomForThread(t);
+            SimulationStats stats(rules.cells());
+            for (int pairing = 0; pairing < pairings; ++pairing) {
+                BotPlayer::Difficulty first = difficulties[pairing / difficulties.size()];
+                BotPlayer::Difficulty second = difficulties[pairing % difficulties.size()];
+                BotPlayer firstBot(first), secondBot(second);
+                for (int i = t; i < matches; i += threads) {
+                    MatchResult result = playMatch(firstBot, secondBot, rules);
+                    stats.addMatch(first, second, result);
+                    if (ladder) ladderWinners[size_t(i) * pairings + pairing] = qint8(result.winner);
+                }
+            }
+            QMutexLocker locker(&mergeMutex);
+            combined.merge(stats);
+            latency.merge(LatencyRecorder::local());
+        });
+    }
+    for (std::thread &worker : workers) worker.join();
+
+    if (ladder) {
+        // One ladder player per bot configuration: difficulty and rules. Elo
+        // and Glicko depend on the order of games, so every pairing's match i
+        // is recorded before any match i + 1; in blocks by pairing, the last
+        // pairing played would dominate the ratings.
+        QString spec = " " + rules.toString();
+        QStringList names;
+        for (BotPlayer::Difficulty difficulty : difficulties) names.append(BotPlayer::difficultyName(difficulty) + spec);
+        for (size_t game = 0; game < ladderWinners.size(); ++game) {
+            int first = int(game % pairings) / difficulties.size();
+            int second = int(game % pairings) % difficulties.size();
+            if (difficulties[first] == difficulties[second]) continue;
+            int winner = ladderWinners[game];
+            ladder->record(names[first], names[second], winner < 0 ? 0.5 : winner == 0 ? 1.0 : 0.0);
+        }
+    }
+    return combined;
+}
+
+// Large "ocean" game on a SparseBoard: one ship per 250 cells, then random
+// shots over a twentieth of the area. Reports how many tiles were touched.
+static void runOcean(int size, QTextStream &out) {
+    SparseBoard board(size, size);
+    int fleet = qMax(1, int(qint64(size) * size / 250));
+    for (int i = 0; i < fleet; ++i) {
+        int shipLength = 2 + engineRandom(4);
+        bool isVertical;
+        int row, col;
+        do {
+            isVertical = engineRandom(2) != 0;
+            row = engineRandom(size);
+            col = engineRandom(size);
+        } while (!board.isValidPosition(row, col, isVertical, shipLength));
+        board.placeShip(row, col, isVertical, shipLength);
+    }
+
+    qint64 volley = qMax<qint64>(1, qint64(size) * size / 20);
+    qint64 hits = 0;
+    for (qint64 i = 0; i < volley; ++i) {
+        if (board.attack(engineRandom(size), engineRandom(size))) hits++;
+    }
+    qint64 tilesAcross = (size + 7) / 8;
+    out << QString("ocean %1x%1: %2 ships, %3 shots, %4 hits, %5 afloat, %6 of %7 tiles stored\n")
+               .arg(size)
+               .arg(fleet)
+               .arg(volley)
+               .arg(hits)
+               .arg(board.shipsAfloat())
+               .arg(board.tileCount())
+               .arg(tilesAcross * tilesAcross);
+}
+
+// Plays a copy of every stored game through the batch bot's shot order and
+// returns games per second.
+template <class Game>
+static double replayStoredGames(const QVector<Game> &games, const QVector<int> &order, int cols, qint64 &shots) {
+    auto start = std::chrono::steady_clock::now();
+    for (const Game &stored : games) {
+        Game game = stored;
+        for (int cell : order) {
+            if (!game.hasShipsRemaining()) break;
+            game.attack(cell / cols, cell % cols);
+            shots++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return games.size() / seconds;
+}
+
+// The same dealt fleets kept in memory as an array of Board and as an array
+// of compact boards, then replayed from the array.
+template <class Compact>
+static void runStoredGames(const RuleSet &rules, int games, QTextStream &out) {
+    QVector<Board> boards;
+    QVector<Compact> compact;
+    boards.reserve(games);
+    compact.reserve(games);
+    for (int game = 0; game < games; ++game) {
+        Board board(rules);
+        BotPlayer::placeShips(board, rules);
+        boards.append(board);
+        compact.append(Compact::fromBoard(board));
+    }
+
+    QVector<int> order = BatchSimulator::shotOrder(rules);
+    qint64 boardShots = 0, compactShots = 0;
+    double boardRate = replayStoredGames(boards, order, rules.cols, boardShots);
+    double compactRate = replayStoredGames(compact, order, rules.cols, compactShots);
+    out << QString("stored   : %1 games/s, %2 shots per game, %3 bytes per game\n")
+               .arg(boardRate, 0, 'f', 0)
+               .arg(double(boardShots) / games, 0, 'f', 2)
+               .arg(int(sizeof(Board)));
+    out << QString("compact  : %1 games/s, %2 shots per game, %3 bytes per game, %4x stored\n")
+               .arg(compactRate, 0, 'f', 0)
+               .arg(double(compactShots) / games, 0, 'f', 2)
+               .arg(int(sizeof(Compact)))
+               .arg(compactRate / boardRate, 0, 'f', 1);
+}
+
+// Deals a fleet the way BatchSimulator does: a random precomputed position
+// per ship, drawn again while it overlaps the ships already placed.
+static void dealFleet(Board &board, const RuleSet &rules, const QVector<QVector<CellMask>> &placements) {
+    CellMask fleet;
+    for (int ship = 0; ship < placements.size(); ++ship) {
+        const CellMask *position;
+        do {
+            position = &placements[ship][engineRandom(placements[ship].size())];
+        } while (!(*position & fleet).isEmpty());
+        fleet |= *position;
+        int first = position->select(0);
+        bool vertical = rules.shipLengths[ship] > 1 && position->select(1) == first + rules.cols;
+        board.placeShip(first / rules.cols, first % rules.cols, vertical, rules.shipLengths[ship]);
+    }
+}
+
+// Games per second for the lockstep batch simulator, against the same bot run
+// one game at a time on Board and on stored Board and CompactBoard games.
+// Latency probes are off so all sides run bare. The Board baseline gets the
+// kernels' advantages too: one shot order and precomputed ship positions.
+static void runBatchBenchmark(const RuleSet &rules, int games, QTextStream &out) {
+    bool probes = LatencyRecorder::isEnabled();
+    LatencyRecorder::setEnabled(false);
+    int batches = qMax(1, (games + BatchSimulator::LANES - 1) / BatchSimulator::LANES);
+    games = batches * BatchSimulator::LANES;
+
+    QVector<QVector<CellMask>> placements;
+    for (int shipLength : rules.shipLengths) placements.append(shipPositions(rules, shipLength));
+    QVector<int> order = BatchSimulator::shotOrder(rules);
+
+    auto start = std::chrono::steady_clock::now();
+    qint64 boardShots = 0;
+    for (int game = 0; game < games; ++game) {
+        Board board(rules);
+        dealFleet(board, rules, placements);
+        for (int cell : order) {
+            if (!board.hasShipsRemaining()) break;
+            board.attack(cell / rules.cols, cell % rules.cols);
+            boardShots++;
+        }
+    }
+    double boardSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double boardRate = games / boardSeconds;
+    out << QString("board    : %1 games/s, %2 shots per game\n")
+               .arg(boardRate, 0, 'f', 0)
+               .arg(double(boardShots) / games, 0, 'f', 2);
+
+    const BatchSimulator::Kernel kernels[] = {BatchSimulator::Scalar, BatchSimulator::Sse2, BatchSimulator::Avx2};
+    for (BatchSimulator::Kernel kernel : kernels) {
+        if (!BatchSimulator::isSupported(kernel)) continue;
+        BatchSimulator simulator(rules, kernel);
+        quint64 shots[BatchSimulator::LANES];
+        qint64 totalShots = 0;
+        start = std::chrono::steady_clock::now();
+        for (int batch = 0; batch < batches; ++batch) {
+            simulator.playBatch(shots);
+            for (int lane = 0; lane < BatchSimulator::LANES; ++lane) totalShots += shots[lane];
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        out << QString("%1: %2 games/s, %3 shots per game, %4x board\n")
+                   .arg(QString(BatchSimulator::kernelName(kernel)).leftJustified(9))
+                   .arg(games / seconds, 0, 'f', 0)
+                   .arg(double(totalShots) / games, 0, 'f', 2)
+                   .arg(games / seconds / boardRate, 0, 'f', 1);
+    }
+
+    if (SmallCompactBoard::fits(rules)) runStoredGames<SmallCompactBoard>(rules, games, out);
+    else runStoredGames<CompactBoard<>>(rules, games, out);
+    LatencyRecorder::setEnabled(probes);
+}
+
+// Speaks the engine protocol on stdin/stdout until quit or end of input.
+static void runEngine(BotPlayer::Difficulty difficulty) {
+    ProtocolEngine engine(difficulty);
+    QTextStream in(stdin);
+    QTextStream out(stdout);
+    QString line;
+    while (!engine.isFinished() && in.readLineInto(&line)) {
+        QString reply = engine.handle(line);
+        if (reply.isEmpty()) continue;
+        out << reply << '\n';
+        out.flush();
+    }
+}
+
+// An external protocol engine against each bot; sides alternate firing first.
+static bool runOpponent(const QString &command, const QVector<BotPlayer::Difficulty> &difficulties, int games,
+                        const RuleSet &rules, QTextStream &out) {
+    ExternalEngine engine(command);
+    if (!engine.start()) {
+        qWarning("engine: %s", qPrintable(engine.error()));
+        return false;
+    }
+    for (BotPlayer::Difficulty difficulty : difficulties) {
+        BotPlayer bot(difficulty);
+        int wins[2] = {0, 0};
+        qint64 shots[2] = {0, 0};
+        for (int i = 0; i < games; ++i) {
+            MatchResult result = playExternalMatch(engine, bot, rules, i % 2 == 0);
+            if (!engine.error().isEmpty()) {
+                qWarning("engine: %s", qPrintable(engine.error()));
+                return false;
+            }
+            if (result.winner >= 0) wins[result.winner]++;
+            shots[0] += result.shots[0];
+            shots[1] += result.shots[1];
+        }
+        out << QString("%1 vs %2: %3 games, %4-%5, %6 vs %7 shots per game\n")
+                   .arg(engine.name(), BotPlayer::difficultyName(difficulty))
+                   .arg(games)
+                   .arg(wins[0])
+                   .arg(wins[1])
+                   .arg(games ? double(shots[0]) / games : 0.0, 0, 'f', 2)
+                   .arg(games ? double(shots[1]) / games : 0.0, 0, 'f', 2);
+    }
+    return true;
+}
+
+// Optimal policy for a small rule set, written as a table for --policy.
+static bool runSolver(const RuleSet &rules, int threads, const QString &path, QTextStream &out) {
+    if (!ExactSolver::isSolvable(rules)) {
+        qWarning("The exact solver needs a grid of at most %d cells and no salvo", ExactSolver::MAX_CELLS);
+        return false;
+    }
+    auto start = std::chrono::steady_clock::now();
+    ExactSolver solver(rules);
+    solver.setThreads(threads);
+    if (!solver.solve()) {
+        qWarning("%s has too many states to solve exactly", qPrintable(rules.toString()));
+        return false;
+    }
+    PolicyTable table = solver.policy();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    out << QString("exact %1: %2 fleets, %3 states, %4 expected shots, %5 table entries, %6 s\n")
+               .arg(rules.toString())
+               .arg(solver.fleetCount())
+               .arg(solver.statesSolved())
+               .arg(solver.expectedShots(), 0, 'f', 4)
+               .arg(table.size())
+               .arg(seconds, 0, 'f', 1);
+    if (!table.save(path)) {
+        qWarning("Could not write %s", qPrintable(path));
+        return false;
+    }
+    return true;
+}
+
+static bool writeFile(const QString &path, const QString &contents) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+    QTextStream(&file) << contents;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("battleship_headless");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs Battleship bots without the GUI.");
+    parser.addHelpOption();
+    QCommandLineOption gamesOption("games", "Games to play per difficulty.", "n", "1000");
+    QCommandLineOption rulesOption("rules", "Rule set: classic, compact[:ships] or RxC:len,len,..., optionally /salvo or /salvo:n", "spec", "classic");
+    QCommandLineOption difficultyOption("difficulty", "Comma separated difficulties to run.", "list",
+                                        "Easy,Medium,Hard,Expert");
+    QCommandLineOption seedOption("seed", "Random seed.", "n");
+    QCommandLineOption jsonOption("latency-json", "Write latency histograms as JSON.", "file");
+    QCommandLineOption csvOption("latency-csv", "Write latency histograms as CSV.", "file");
+    QCommandLineOption traceOption("trace", "Write bot and board spans as Chrome trace JSON.", "file");
+    QCommandLineOption matchesOption("matches", "Play bot-vs-bot matches per difficulty pairing instead of solo games.", "n");
+    QCommandLineOption threadsOption("threads", "Worker threads for --matches and --solve.", "n",
+                                     QString::number(qMax(1u, std::thread::hardware_concurrency())));
+    QCommandLineOption statsOption("stats-json", "Write match statistics as JSON.", "file");
+    QCommandLineOption fuzzOption("fuzz", "Check Board against the reference implementation over n random games.", "n");
+    QCommandLineOption oceanOption("ocean", "Play random shots on a sparse n x n ocean board.", "n");
+    QCommandLineOption batchOption("batch", "Benchmark the lockstep batch simulator and compact boards against Board over n games.", "n");
+    QCommandLineOption engineOption("engine", "Act as a protocol engine on stdin/stdout, playing as the first --difficulty.");
+    QCommandLineOption opponentOption("opponent", "Play --games matches of an external protocol engine against each bot.",
+                                      "command");
+    QCommandLineOption solveOption("solve", "Solve --rules exactly (small boards only) and write the policy table.",
+                                   "file");
+    QCommandLineOption policyOption("policy", "Let the bots in solo games follow a policy table from --solve.", "file");
+    QCommandLineOption eventLogOption("event-log", "Write every shot of the solo games to a file, from a second thread.",
+                                      "file");
+    QCommandLineOption ratingsOption("ratings", "Add the --matches results to a rating ladder log and print its leaderboard.",
+                                     "file");
+    QCommandLineOption leaderboardOption("leaderboard", "Print the --ratings leaderboard and exit.");
+    parser.addOptions({gamesOption, rulesOption, difficultyOption, seedOption, jsonOption, csvOption, traceOption,
+                       matchesOption, threadsOption, statsOption, fuzzOption, oceanOption, batchOption, engineOption,
+                       opponentOption, solveOption, policyOption, eventLogOption, ratingsOption, leaderboardOption});
+    parser.process(app);
+
+    int games = parser.value(gamesOption).toInt();
+    bool rulesOk = false;
+    RuleSet rules = RuleSet::parse(parser.value(rulesOption), &rulesOk);
+    if (!rulesOk) {
+        qWarning("Invalid rule set %s", qPrintable(parser.value(rulesOption)));
+        return 1;
+    }
+    // The pid keeps engines an arbiter starts in the same second apart
+    seedEngineRandom(parser.isSet(seedOption) ? parser.value(seedOption).toUInt()
+                                              : static_cast<quint32>(time(nullptr) ^ (QCoreApplication::applicationPid() << 16)));
+
+    QVector<BotPlayer::Difficulty> difficulties;
+    for (const QString &name : parser.value(difficultyOption).split(',')) {
+        difficulties.append(BotPlayer::difficultyFromName(name.trimmed()));
+    }
+
+    if (parser.isSet(engineOption)) {
+        runEngine(difficulties.value(0, BotPlayer::Expert));
+        return 0;
+    }
+
+    QTextStream out(stdout);
+    RatingLadder ladder;
+    if (parser.isSet(ratingsOption) && !ladder.open(parser.value(ratingsOption))) {
+        qWarning("%s is not a rating ladder log", qPrintable(parser.value(ratingsOption)));
+        return 1;
+    }
+    if (parser.isSet(leaderboardOption)) {
+        out << ladder.toText();
+        out.flush();
+        return 0;
+    }
+
+    if (parser.isSet(fuzzOption)) {
+        BoardFuzzer fuzzer(rules);
+        bool passed = fuzzer.run(parser.value(fuzzOption).toInt());
+        out << QString("fuzz: %1 attacks checked\n").arg(fuzzer.attacksChecked());
+        out.flush();
+        if (!passed) {
+            qWarning("fuzz: %s", qPrintable(fuzzer.failure()));
+            return 1;
+        }
+        return 0;
+    }
+
+    if (parser.isSet(solveOption)) {
+        bool solved = runSolver(rules, qMax(1, parser.value(threadsOption).toInt()), parser.value(solveOption), out);
+        out.flush();
+        return solved ? 0 : 1;
+    }
+
+    PolicyTable policy;
+    if (parser.isSet(policyOption)) {
+        if (!policy.load(parser.value(policyOption)) || policy.rules().rows != rules.rows
+            || policy.rules().cols != rules.cols || policy.rules().shipLengths != rules.shipLengths) {
+            qWarning("%s is not a policy table for %s", qPrintable(parser.value(policyOption)),
+                     qPrintable(rules.toString()));
+            return 1;
+        }
+        out << QString("policy: %1 entries, %2 expected shots\n").arg(policy.size()).arg(policy.expectedShots(), 0, 'f', 4);
+    }
+
+    LatencyRecorder::setEnabled(true);
+    if (parser.isSet(traceOption)) {
+        TraceRecorder::start();
+    }
+
+    if (parser.isSet(opponentOption)) {
+        if (rules.isSalvo()) {
+            qWarning("The engine protocol has no salvo rules");
+            return 1;
+        }
+        if (!runOpponent(parser.value(opponentOption), difficulties, games, rules, out)) return 1;
+    } else if (parser.isSet(batchOption)) {
+        runBatchBenchmark(rules, qMax(1, parser.value(batchOption).toInt()), out);
+    } else if (parser.isSet(oceanOption)) {
+        runOcean(qMax(1, parser.value(oceanOption).toInt()), out);
+    } else if (parser.isSet(matchesOption)) {
+        int threads = qMax(1, parser.value(threadsOption).toInt());
+        SimulationStats stats = runMatches(difficulties, parser.value(matchesOption).toInt(), rules, threads,
+                                           ladder.isOpen() ? &ladder : nullptr);
+        out << stats.toText();
+        if (ladder.isOpen()) {
+            out << "\n" << ladder.toText();
+            if (!ladder.close()) {
+                qWarning("Could not write %s", qPrintable(parser.value(ratingsOption)));
+                return 1;
+            }
+        }
+        if (parser.isSet(statsOption) && !writeFile(parser.value(statsOption), stats.toJson())) {
+            qWarning("Could not write %s", qPrintable(parser.value(statsOption)));
+            return 1;
+        }
+    } else {
+        GameEventStream events;
+        int logEvents = events.subscribe();
+        QFile eventLog(parser.value(eventLogOption));
+        std::atomic<bool> playing(true);
+        std::thread writer;
+        if (parser.isSet(eventLogOption)) {
+            if (!eventLog.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                qWarning("Could not write %s", qPrintable(eventLog.fileName()));
+                return 1;
+            }
+            writer = std::thread([&]() { writeEventLog(events, logEvents, eventLog, playing); });
+        }
+
+        for (BotPlayer::Difficulty difficulty : difficulties) {
+            BotPlayer bot(difficulty);
+            bot.setPolicyTable(policy);
+            qint64 totalShots = 0;
+            for (int i = 0; i < games; ++i) {
+                totalShots += playSoloGame(bot, rules, writer.joinable() ? &events : nullptr);
+            }
+            out << QString("%1: %2 games, %3 shots per game\n")
+                       .arg(BotPlayer::difficultyName(bot.difficulty()))
+                       .arg(games)
+                       .arg(games ? double(totalShots) / games : 0.0, 0, 'f', 2);
+        }
+
+        if (writer.joinable()) {
+            playing.store(false, std::memory_order_release);
+            writer.join();
+            out << QString("event log: %1 events dropped\n").arg(events.dropped(logEvents));
+        }
+    }
+
+    out << "\n" << LatencyRecorder::local().toText();
+    out.flush();
+
+    if (parser.isSet(traceOption)) {
+        TraceRecorder::stop();
+        if (!TraceRecorder::write(parser.value(traceOption))) {
+            qWarning("Could not write %s", qPrintable(parser.value(traceOption)));
+            return 1;
+        }
+    }
+    if (parser.isSet(jsonOption) && !writeFile(parser.value(jsonOption), LatencyRecorder::local().toJson())) {
+        qWarning("Could not write %s", qPrintable(parser.value(jsonOption)));
+        return 1;
+    }
+    if (parser.isSet(csvOption) && !writeFile(parser.value(csvOption), LatencyRecorder::local().toCsv())) {
+        qWarning("Could not write %s", qPrintable(parser.value(csvOption)));
+        return 1;
+    }
+    return 0;
+}
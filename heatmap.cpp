@@ -0,0 +1,84 @@
+#include "heatmap.h"
+#include "enginerandom.h"
+#include <cstring>
+
+void ShotHeatmap::build(const Board &target, const CellMask &assumedMisses, int weights[MAX_GRID_CELLS]) {
+    int rows = target.rows();
+    int cols = target.cols();
+    memset(weights, 0, sizeof(int) * MAX_GRID_CELLS);
+
+    // What the shooter knows: open hits, and cells no afloat ship can use
+    CellMask untried = target.untriedMask();
+    CellMask openHits;
+    CellMask blocked = assumedMisses;
+    for (int cell = 0; cell < rows * cols; ++cell) {
+        if (untried.test(cell)) continue;
+        int row = cell / cols;
+        int col = cell % cols;
+        if (target.shipAt(row, col) >= 0 && !target.isSunkAt(row, col)) openHits.set(cell);
+        else blocked.set(cell);
+    }
+
+    const Fleet &fleet = target.fleet();
+    for (int id = 0; id < fleet.count; ++id) {
+        if (target.isShipSunk(id)) continue;
+        int length = fleet.length[id];
+        for (int vertical = 0; vertical < 2; ++vertical) {
+            int step = vertical ? cols : 1;
+            int lastRow = vertical ? rows - length : rows - 1;
+            int lastCol = vertical ? cols - 1 : cols - length;
+            for (int row = 0; row <= lastRow; ++row) {
+                for (int col = 0; col <= lastCol; ++col) {
+                    int first = row * cols + col;
+                    int hits = 0;
+                    bool open = true;
+                    for (int i = 0; i < length && open; ++i) {
+                        int cell = first + i * step;
+                        open = !blocked.test(cell);
+                        hits += openHits.test(cell);
+                    }
+                    if (!open) continue;
+                    int weight = 1 + hits * HIT_WEIGHT;
+                    for (int i = 0; i < length; ++i) {
+                        int cell = first + i * step;
+                        if (untried.test(cell)) weights[cell] += weight;
+                    }
+                }
+            }
+        }
+    }
+}
+
+CellMask ShotHeatmap::chooseSalvo(const Board &target, int shots, const CellMask &preferred) {
+    CellMask chosen;
+    CellMask candidates = target.untriedMask();
+    int weights[MAX_GRID_CELLS];
+
+    for (int shot = 0; shot < shots && !candidates.isEmpty(); ++shot) {
+        build(target, chosen, weights);
+
+        // Highest weight wins, then preferred cells; other ties are broken uniformly at random
+        int best = -1;
+        bool bestPreferred = false;
+        int ties = 0;
+        for (int w = 0; w < CellMask::WORDS; ++w) {
+            quint64 word = candidates.words[w];
+            while (word) {
+                int cell = w * 64 + qCountTrailingZeroBits(word);
+                word &= word - 1;
+                bool isPreferred = preferred.test(cell);
+                if (best < 0 || weights[cell] > weights[best]
+                    || (weights[cell] == weights[best] && isPreferred && !bestPreferred)) {
+                    best = cell;
+                    bestPreferred = isPreferred;
+                    ties = 1;
+                } else if (weights[cell] == weights[best] && isPreferred == bestPreferred && engineRandom(++ties) == 0) {
+                    best = cell;
+                }
+            }
+        }
+        chosen.set(best);
+        candidates.reset(best);
+    }
+    return chosen;
+}
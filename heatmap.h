@@ -0,0 +1,23 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+#include "board.h"
+
+// Placement-count heatmap: for every ship still afloat, every position that
+// avoids known misses and sunk ships adds weight to the untried cells it
+// covers. Positions through unresolved hits count HIT_WEIGHT times more per hit.
+class ShotHeatmap {
+public:
+    static const int HIT_WEIGHT = 40;
+
+    // weights[cell] for every cell of the board; cells in `assumedMisses` are
+    // treated as misses (used to spread a salvo).
+    static void build(const Board &target, const CellMask &assumedMisses, int weights[MAX_GRID_CELLS]);
+
+    // Up to `shots` untried cells chosen jointly: each pick assumes the earlier
+    // ones missed, so a salvo fans out instead of stacking on one hot spot.
+    // Equal weights go to cells in `preferred` first.
+    static CellMask chooseSalvo(const Board &target, int shots, const CellMask &preferred = CellMask());
+};
+
+#endif // HEATMAP_H
@@ -0,0 +1,77 @@
+#include "huntpolicy.h"
+#include "enginerandom.h"
+
+namespace {
+
+// Lattice masks for one grid shape: masks[k][offset] for 1 <= k <= MAX_GRID_SIZE
+struct LatticeTable {
+    int rows = 0;
+    int cols = 0;
+    CellMask masks[MAX_GRID_SIZE + 1][MAX_GRID_SIZE];
+
+    void build(int newRows, int newCols) {
+        rows = newRows;
+        cols = newCols;
+        for (int k = 1; k <= MAX_GRID_SIZE; ++k) {
+            for (int offset = 0; offset < k; ++offset) masks[k][offset] = CellMask();
+            for (int row = 0; row < rows; ++row) {
+                for (int col = 0; col < cols; ++col) {
+                    masks[k][(row + col) % k].set(row * cols + col);
+                }
+            }
+        }
+    }
+};
+
+// Rebuilt only when the grid shape changes, i.e. once per rule set
+const LatticeTable &latticeTable(int rows, int cols) {
+    static thread_local LatticeTable table;
+    if (table.rows != rows || table.cols != cols) table.build(rows, cols);
+    return table;
+}
+
+}
+
+const CellMask &ParityHuntPolicy::latticeMask(int rows, int cols, int k, int offset) {
+    return latticeTable(rows, cols).masks[k][offset];
+}
+
+bool ParityHuntPolicy::chooseShot(const Board &board, int &row, int &col, const CellMask &preferred) {
+    return chooseShot(board.untriedMask(), board.smallestShipRemaining(), board.rows(), board.cols(), row, col, preferred);
+}
+
+bool ParityHuntPolicy::chooseShot(const CellMask &untried, int smallestShip, int rows, int cols, int &row, int &col,
+                                  const CellMask &preferred) {
+    if (untried.isEmpty()) return false;
+
+    int k = qBound(1, smallestShip, MAX_GRID_SIZE);
+    const LatticeTable &table = latticeTable(rows, cols);
+
+    // Pick the lattice with the fewest untried cells left: it still crosses
+    // every remaining ship, so it is the cheapest one to sweep.
+    CellMask candidates;
+    int best = 0;
+    for (int offset = 0; offset < k; ++offset) {
+        CellMask lattice = table.masks[k][offset] & untried;
+        int remaining = lattice.count();
+        if (remaining > 0 && (best == 0 || remaining < best)) {
+            best = remaining;
+            candidates = lattice;
+        }
+    }
+    if (best == 0) {
+        candidates = untried;
+        best = untried.count();
+    }
+    CellMask favoured = candidates & preferred;
+    int favouredCount = favoured.count();
+    if (favouredCount > 0) {
+        candidates = favoured;
+        best = favouredCount;
+    }
+
+    int cell = candidates.select(engineRandom(best));
+    row = cell / cols;
+    col = cell % cols;
+    return true;
+}
@@ -0,0 +1,18 @@
+#ifndef HUNTPOLICY_H
+#define HUNTPOLICY_H
+
+#include "board.h"
+
+// Hunt-phase shot selection restricted to the lattice (row + col) % k == offset,
+// where k is the smallest ship still afloat. Every such ship must cross every
+// lattice line, so the other cells never need to be searched. Lattice cells
+// in `preferred` (an opponent's favourite cells) are searched first.
+class ParityHuntPolicy {
+public:
+    static const CellMask &latticeMask(int rows, int cols, int k, int offset);
+    static bool chooseShot(const Board &board, int &row, int &col, const CellMask &preferred = CellMask());
+    static bool chooseShot(const CellMask &untried, int smallestShip, int rows, int cols, int &row, int &col,
+                           const CellMask &preferred = CellMask());
+};
+
+#endif // HUNTPOLICY_H
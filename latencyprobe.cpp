@@ -0,0 +1,183 @@
+#include "latencyprobe.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstring>
+#include <limits>
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    total = 0;
+    minimum = std::numeric_limits<qint64>::max();
+    maximum = 0;
+    sum = 0;
+}
+
+int LatencyHistogram::bucketFor(qint64 nanos) {
+    if (nanos < SUB_BUCKETS) return nanos < 0 ? 0 : int(nanos);
+    int msb = 63 - qCountLeadingZeroBits(quint64(nanos));
+    int shift = msb - SUB_BITS + 1;
+    if (shift > MAX_SHIFT) return BUCKETS - 1;
+    int sub = int(nanos >> shift);
+    return SUB_BUCKETS + (shift - 1) * HALF + (sub - HALF);
+}
+
+qint64 LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) return bucket;
+    int shift = (bucket - SUB_BUCKETS) / HALF + 1;
+    qint64 sub = (bucket - SUB_BUCKETS) % HALF + HALF;
+    return ((sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(qint64 nanos) {
+    buckets[bucketFor(nanos)]++;
+    total++;
+    sum += nanos;
+    if (nanos < minimum) minimum = nanos;
+    if (nanos > maximum) maximum = nanos;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (int i = 0; i < BUCKETS; ++i) buckets[i] += other.buckets[i];
+    total += other.total;
+    sum += other.sum;
+    minimum = qMin(minimum, other.minimum);
+    maximum = qMax(maximum, other.maximum);
+}
+
+quint64 LatencyHistogram::count() const {
+    return total;
+}
+
+qint64 LatencyHistogram::min() const {
+    return total ? minimum : 0;
+}
+
+qint64 LatencyHistogram::max() const {
+    return maximum;
+}
+
+double LatencyHistogram::mean() const {
+    return total ? sum / total : 0.0;
+}
+
+// Upper bound of the bucket holding the p-th percentile (0 <= p <= 100).
+qint64 LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    quint64 rank = quint64(p / 100.0 * total + 0.5);
+    if (rank < 1) rank = 1;
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) return qMin(bucketUpperBound(i), maximum);
+    }
+    return maximum;
+}
+
+std::atomic<bool> LatencyRecorder::enabledFlag(false);
+
+LatencyRecorder &LatencyRecorder::local() {
+    static thread_local LatencyRecorder recorder;
+    return recorder;
+}
+
+void LatencyRecorder::setEnabled(bool enabled) {
+    enabledFlag.store(enabled, std::memory_order_relaxed);
+}
+
+bool LatencyRecorder::isEnabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+LatencyHistogram *LatencyRecorder::target(const char *name) {
+    if (!enabledFlag.load(std::memory_order_relaxed)) return nullptr;
+    return &local().histogram(name);
+}
+
+LatencyRecorder::~LatencyRecorder() {
+    qDeleteAll(histograms);
+}
+
+LatencyHistogram &LatencyRecorder::histogram(const char *name) {
+    // Probe names are string literals, so the pointer compare almost always hits
+    for (Entry *entry : histograms) {
+        if (entry->name == name) return entry->histogram;
+    }
+    for (Entry *entry : histograms) {
+        if (strcmp(entry->name, name) == 0) return entry->histogram;
+    }
+    Entry *entry = new Entry;
+    entry->name = name;
+    histograms.append(entry);
+    return entry->histogram;
+}
+
+const QVector<LatencyRecorder::Entry *> &LatencyRecorder::entries() const {
+    return histograms;
+}
+
+void LatencyRecorder::merge(const LatencyRecorder &other) {
+    for (const Entry *entry : other.histograms) {
+        histogram(entry->name).merge(entry->histogram);
+    }
+}
+
+void LatencyRecorder::reset() {
+    for (Entry *entry : histograms) entry->histogram.reset();
+}
+
+QString LatencyRecorder::toJson() const {
+    QJsonArray list;
+    for (const Entry *entry : histograms) {
+        const LatencyHistogram &h = entry->histogram;
+        QJsonObject object;
+        object["name"] = QString::fromLatin1(entry->name);
+        object["count"] = double(h.count());
+        object["mean_ns"] = h.mean();
+        object["min_ns"] = double(h.min());
+        object["p50_ns"] = double(h.percentile(50));
+        object["p90_ns"] = double(h.percentile(90));
+        object["p99_ns"] = double(h.percentile(99));
+        object["max_ns"] = double(h.max());
+        list.append(object);
+    }
+    QJsonObject root;
+    root["latency"] = list;
+    return QString::fromUtf8(QJsonDocument(root).toJson());
+}
+
+QString LatencyRecorder::toCsv() const {
+    QString csv = "name,count,mean_ns,min_ns,p50_ns,p90_ns,p99_ns,max_ns\n";
+    for (const Entry *entry : histograms) {
+        const LatencyHistogram &h = entry->histogram;
+        csv += QString("%1,%2,%3,%4,%5,%6,%7,%8\n")
+                   .arg(QString::fromLatin1(entry->name))
+                   .arg(h.count())
+                   .arg(h.mean(), 0, 'f', 1)
+                   .arg(h.min())
+                   .arg(h.percentile(50))
+                   .arg(h.percentile(90))
+                   .arg(h.percentile(99))
+                   .arg(h.max());
+    }
+    return csv;
+}
+
+QString LatencyRecorder::toText() const {
+    QString text = QString("%1 %2 %3 %4 %5\n")
+                       .arg("probe", -16).arg("count", 10).arg("p50 us", 10).arg("p99 us", 10).arg("max us", 10);
+    for (const Entry *entry : histograms) {
+        const LatencyHistogram &h = entry->histogram;
+        text += QString("%1 %2 %3 %4 %5\n")
+                    .arg(QString::fromLatin1(entry->name), -16)
+                    .arg(h.count(), 10)
+                    .arg(h.percentile(50) / 1000.0, 10, 'f', 2)
+                    .arg(h.percentile(99) / 1000.0, 10, 'f', 2)
+                    .arg(h.max() / 1000.0, 10, 'f', 2);
+    }
+    return text;
+}
@@ -0,0 +1,99 @@
+#ifndef LATENCYPROBE_H
+#define LATENCYPROBE_H
+
+#include <QtGlobal>
+#include <QtAlgorithms>
+#include <QString>
+#include <QVector>
+#include <atomic>
+#include <chrono>
+
+// HDR-style latency histogram: exact below 32ns, then 16 linear sub-buckets per
+// power of two (worst-case relative error ~6%). Fixed size, mergeable.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(qint64 nanos);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    quint64 count() const;
+    qint64 min() const;
+    qint64 max() const;
+    double mean() const;
+    qint64 percentile(double p) const;
+
+private:
+    enum { SUB_BITS = 5, SUB_BUCKETS = 1 << SUB_BITS, HALF = SUB_BUCKETS / 2, MAX_SHIFT = 40 };
+    enum { BUCKETS = SUB_BUCKETS + MAX_SHIFT * HALF };
+
+    static int bucketFor(qint64 nanos);
+    static qint64 bucketUpperBound(int bucket);
+
+    quint64 buckets[BUCKETS];
+    quint64 total;
+    qint64 minimum;
+    qint64 maximum;
+    double sum;
+};
+
+// Per-thread registry of named histograms. Probes are disabled by default; a
+// disabled probe costs one relaxed atomic load.
+class LatencyRecorder {
+public:
+    struct Entry {
+        const char *name;
+        LatencyHistogram histogram;
+    };
+
+    static LatencyRecorder &local();
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    // Histogram a probe should record into, or nullptr while probes are off.
+    static LatencyHistogram *target(const char *name);
+
+    LatencyHistogram &histogram(const char *name);
+    const QVector<Entry *> &entries() const;
+    void merge(const LatencyRecorder &other);
+    void reset();
+
+    QString toJson() const;
+    QString toCsv() const;
+    QString toText() const;
+
+    LatencyRecorder() = default;
+    ~LatencyRecorder();
+    LatencyRecorder(const LatencyRecorder &) = delete;
+    LatencyRecorder &operator=(const LatencyRecorder &) = delete;
+
+private:
+    static std::atomic<bool> enabledFlag;
+    QVector<Entry *> histograms;
+};
+
+class LatencyProbe {
+public:
+    explicit LatencyProbe(LatencyHistogram *histogram)
+        : histogram(histogram),
+        start(histogram ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point()) {}
+
+    ~LatencyProbe() {
+        if (histogram) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            histogram->record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+    }
+
+    LatencyProbe(const LatencyProbe &) = delete;
+    LatencyProbe &operator=(const LatencyProbe &) = delete;
+
+private:
+    LatencyHistogram *histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+#define LATENCY_PROBE(name) LatencyProbe latencyProbe(LatencyRecorder::target(name))
+
+#endif // LATENCYPROBE_H
@@ -1,11 +1,61 @@
 #include <QApplication>
 #include "BattleshipGame.h"
+#include "spectatordashboard.h"
+#include "latencyprobe.h"
+#include "startupprofile.h"
+#include "tracing.h"
+#include <thread>
 
 int main(int argc, char *argv[]) {
+    // --profile-startup prints where the time to the first paint went. It is
+    // looked for before QApplication so that its construction is measured too.
+    for (int i = 1; i < argc; ++i) {
+        if (qstrcmp(argv[i], "--profile-startup") == 0) {
+            StartupProfile::start();
+        }
+    }
+
     QApplication app(argc, argv);
-    
+    StartupProfile::mark("QApplication");
+    if (app.arguments().contains("--latency")) {
+        LatencyRecorder::setEnabled(true);
+    }
+
+    // --trace <file> records spans and writes them as Chrome trace JSON on exit
+    int traceIndex = app.arguments().indexOf("--trace");
+    QString tracePath = traceIndex > 0 ? app.arguments().value(traceIndex + 1) : QString();
+    if (!tracePath.isEmpty()) {
+        TraceRecorder::start();
+    }
+
+    // --spectate [n] watches n bot-vs-bot games (64 by default) instead of
+    // playing one, with --rules picking the rule set (classic by default)
+    int spectateIndex = app.arguments().indexOf("--spectate");
+    if (spectateIndex > 0) {
+        bool gamesOk = false;
+        int games = app.arguments().value(spectateIndex + 1).toInt(&gamesOk);
+        if (!gamesOk) games = 64;
+        int rulesIndex = app.arguments().indexOf("--rules");
+        bool rulesOk = true;
+        RuleSet rules = rulesIndex > 0 ? RuleSet::parse(app.arguments().value(rulesIndex + 1), &rulesOk) : RuleSet::classic();
+        if (!rulesOk || rules.isSalvo()) {
+            qWarning("The spectator needs a valid rule set without salvo");
+            return 1;
+        }
+        int threads = qMax(1, int(std::thread::hardware_concurrency()) - 1);
+        SpectatorDashboard dashboard(rules, games, threads);
+        dashboard.show();
+        return app.exec();
+    }
+
     BattleshipGame game;
     game.show();
+    StartupProfile::mark("show");
     
-    return app.exec();
+    int result = app.exec();
+    if (!tracePath.isEmpty()) {
+        TraceRecorder::stop();
+        TraceRecorder::write(tracePath);
+    }
+    return result;
 }
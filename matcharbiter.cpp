@@ -0,0 +1,493 @@
+#include "matcharbiter.h"
+#include "engineprotocol.h"
+#include <QProcess>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <fcntl.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char **environ;
+
+static qint64 nowMicros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+EnginePipe::EnginePipe() : pid(-1), input(-1), output(-1) {
+}
+
+// Nobody is left to reap the engine, so it gets no grace period
+EnginePipe::~EnginePipe() {
+    int child = stop();
+    if (child > 0) {
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+    }
+}
+
+bool EnginePipe::spawn(const QString &command) {
+    QStringList arguments = QProcess::splitCommand(command);
+    if (arguments.isEmpty()) return false;
+
+    int toChild[2], fromChild[2];
+    if (pipe(toChild) != 0) return false;
+    if (pipe(fromChild) != 0) {
+        close(toChild[0]);
+        close(toChild[1]);
+        return false;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, toChild[0], STDIN_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, fromChild[1], STDOUT_FILENO);
+    posix_spawn_file_actions_addclose(&actions, toChild[1]);
+    posix_spawn_file_actions_addclose(&actions, fromChild[0]);
+
+    QVector<QByteArray> bytes;
+    for (const QString &argument : arguments) bytes.append(argument.toLocal8Bit());
+    QVector<char *> argv;
+    for (QByteArray &argument : bytes) argv.append(argument.data());
+    argv.append(nullptr);
+
+    pid_t child;
+    int status = posix_spawnp(&child, argv[0], &actions, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&actions);
+    close(toChild[0]);
+    close(fromChild[1]);
+    if (status != 0) {
+        close(toChild[1]);
+        close(fromChild[0]);
+        return false;
+    }
+
+    pid = child;
+    input = toChild[1];
+    output = fromChild[0];
+    fcntl(input, F_SETFD, FD_CLOEXEC);
+    fcntl(output, F_SETFD, FD_CLOEXEC);
+    fcntl(output, F_SETFL, fcntl(output, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+// Commands are a few bytes and at most one is outstanding, so a write never
+// fills the pipe; a failed one means the engine is gone.
+bool EnginePipe::send(const QString &line) {
+    if (input < 0) return false;
+    QByteArray bytes = line.toUtf8() + '\n';
+    return write(input, bytes.constData(), bytes.size()) == bytes.size();
+}
+
+bool EnginePipe::fill() {
+    char chunk[4096];
+    for (;;) {
+        ssize_t got = read(output, chunk, sizeof(chunk));
+        if (got > 0) {
+            buffer.append(chunk, int(got));
+            continue;
+        }
+        if (got < 0 && errno == EINTR) continue;
+        return got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+bool EnginePipe::takeLine(QString &line) {
+    int end = buffer.indexOf('\n');
+    if (end < 0) return false;
+    line = QString::fromUtf8(buffer.left(end)).trimmed();
+    buffer.remove(0, end + 1);
+    return true;
+}
+
+int EnginePipe::stop() {
+    if (pid < 0) return -1;
+    send("quit");
+    close(input);
+    close(output);
+    input = output = -1;
+    int child = pid;
+    pid = -1;
+    return child;
+}
+
+int EnginePipe::readFd() const {
+    return output;
+}
+
+ArbiterMatch::ArbiterMatch(int first, int second, const RuleSet &rules, int games, int moveTimeMs)
+    : rules(rules), gamesLeft(games), gameIndex(0), moveTime(moveTimeMs), phase(NewGame), toMove(0)
+{
+    engines[0] = first;
+    engines[1] = second;
+    for (int side = 0; side < 2; ++side) {
+        awaiting[side] = false;
+        sentAt[side] = 0;
+        deadlines[side] = 0;
+    }
+}
+
+bool ArbiterMatch::start(const QVector<ArbiterEngine> &list, qint64 now) {
+    for (int side = 0; side < 2; ++side) {
+        if (!pipes[side].spawn(list[engines[side]].command)) {
+            current = GameRecord{1 - side, {0, 0}, "could not start", QString()};
+            finished.append(current);
+            phase = Done;
+            return false;
+        }
+    }
+    beginGame(now);
+    return true;
+}
+
+void ArbiterMatch::beginGame(qint64 now) {
+    phase = NewGame;
+    toMove = gameIndex % 2;
+    current = GameRecord{-1, {0, 0}, QString(), QString()};
+    for (int side = 0; side < 2; ++side) {
+        boards[side] = Board(rules);
+        send(side, "newgame " + rules.toString(), now);
+    }
+}
+
+bool ArbiterMatch::send(int side, const QString &line, qint64 now, bool expectReply) {
+    if (!pipes[side].send(line)) {
+        forfeit(side, "exited");
+        return false;
+    }
+    if (expectReply) {
+        awaiting[side] = true;
+        sentAt[side] = now;
+        deadlines[side] = now + qint64(moveTime) * 1000;
+    }
+    return true;
+}
+
+void ArbiterMatch::onReadable(int side, qint64 now) {
+    bool open = pipes[side].fill();
+    QString line;
+    while (phase != Done && pipes[side].takeLine(line)) handleLine(side, line, now);
+    if (!open && phase != Done) forfeit(side, "exited");
+}
+
+void ArbiterMatch::onTimeout(int side) {
+    forfeit(side, "time");
+}
+
+void ArbiterMatch::handleLine(int side, const QString &line, qint64 now) {
+    if (!awaiting[side]) {
+        forfeit(side, "unexpected \"" + line + "\"");
+        return;
+    }
+    awaiting[side] = false;
+    if (now > deadlines[side]) {
+        forfeit(side, "time");
+        return;
+    }
+
+    if (phase == NewGame) {
+        if (line != "ok") {
+            forfeit(side, "newgame: " + line);
+            return;
+        }
+        if (awaiting[1 - side]) return;
+        phase = Placing;
+        if (send(0, "place", now)) send(1, "place", now);
+    } else if (phase == Placing) {
+        if (!placeFleet(side, line)) {
+            forfeit(side, "illegal fleet \"" + line + "\"");
+            return;
+        }
+        if (awaiting[1 - side]) return;
+        phase = Playing;
+        send(toMove, "shot?", now);
+    } else if (phase == Playing) {
+        replyTimes[side].append(now - sentAt[side]);
+        int row, col;
+        Board &target = boards[1 - side];
+        if (side != toMove || !line.startsWith("shot ")
+            || !EngineProtocol::parseCell(line.mid(5), rules, row, col)
+            || !target.isUntriedAt(paddedCell(row, col))) {
+            forfeit(side, "illegal shot \"" + line + "\"");
+            return;
+        }
+
+        bool hit = target.attack(row, col);
+        bool sunk = hit && target.isSunkAt(row, col);
+        QString cell = EngineProtocol::cellName(row, col);
+        current.shots[side]++;
+        current.moves += QString("%1:%2%3 ").arg(side).arg(cell).arg(QChar(sunk ? 's' : hit ? 'h' : 'm'));
+
+        QString result = sunk ? QString("result %1 sunk %2").arg(cell).arg(target.fleet().length[target.shipAt(row, col)])
+                              : QString("result %1 %2").arg(cell, hit ? "hit" : "miss");
+        if (!send(side, result, now, false)) return;
+        if (!target.hasShipsRemaining()) {
+            endGame(side, QString(), now);
+        } else if (current.shots[0] + current.shots[1] >= 2 * rules.cells()) {
+            endGame(-1, "move limit", now);
+        } else {
+            toMove = 1 - toMove;
+            send(toMove, "shot?", now);
+        }
+    }
+}
+
+// "fleet A1h C3v ..." with the ships in rule order, legal on an empty board.
+bool ArbiterMatch::placeFleet(int side, const QString &line) {
+    QStringList words = line.split(' ');
+    if (words.value(0) != "fleet" || words.size() != rules.shipCount() + 1) return false;
+    for (int i = 0; i < rules.shipCount(); ++i) {
+        QString ship = words[i + 1];
+        bool isVertical = ship.endsWith('v');
+        int row, col;
+        if ((!isVertical && !ship.endsWith('h'))
+            || !EngineProtocol::parseCell(ship.left(ship.size() - 1), rules, row, col)
+            || !boards[side].isValidPosition(row, col, isVertical, rules.shipLengths[i])) {
+            return false;
+        }
+        boards[side].placeShip(row, col, isVertical, rules.shipLengths[i]);
+    }
+    return true;
+}
+
+void ArbiterMatch::endGame(int winner, const QString &reason, qint64 now) {
+    current.winner = winner;
+    current.reason = reason;
+    current.moves = current.moves.trimmed();
+    finished.append(current);
+    gameIndex++;
+    if (--gamesLeft > 0 && reason.isEmpty()) {
+        beginGame(now);
+    } else {
+        phase = Done;
+    }
+}
+
+// A side that misbehaved cannot be trusted to stay in step, so the match ends.
+void ArbiterMatch::forfeit(int side, const QString &reason) {
+    if (phase == Done) return;
+    awaiting[0] = awaiting[1] = false;
+    current.winner = 1 - side;
+    current.reason = reason;
+    current.moves = current.moves.trimmed();
+    finished.append(current);
+    phase = Done;
+}
+
+bool ArbiterMatch::isDone() const {
+    return phase == Done;
+}
+
+bool ArbiterMatch::isAwaiting(int side) const {
+    return awaiting[side];
+}
+
+qint64 ArbiterMatch::deadline(int side) const {
+    return deadlines[side];
+}
+
+int ArbiterMatch::readFd(int side) const {
+    return pipes[side].readFd();
+}
+
+int ArbiterMatch::engine(int side) const {
+    return engines[side];
+}
+
+QVector<int> ArbiterMatch::stopEngines() {
+    QVector<int> pids;
+    for (int side = 0; side < 2; ++side) {
+        int pid = pipes[side].stop();
+        if (pid > 0) pids.append(pid);
+    }
+    return pids;
+}
+
+QVector<ArbiterMatch::GameRecord> ArbiterMatch::takeFinished() {
+    QVector<GameRecord> games;
+    games.swap(finished);
+    return games;
+}
+
+QVector<qint64> ArbiterMatch::takeReplyTimes(int side) {
+    QVector<qint64> times;
+    times.swap(replyTimes[side]);
+    return times;
+}
+
+MatchArbiter::MatchArbiter(const QVector<ArbiterEngine> &engines, const RuleSet &rules)
+    : engines(engines), rules(rules), concurrency(1), moveTime(1000), gamesPerMatch(10), moveLog(nullptr), ratingLadder(nullptr),
+    engineStats(engines.size()), pairWins(engines.size(), QVector<int>(engines.size(), 0))
+{
+}
+
+void MatchArbiter::setConcurrency(int matches) {
+    concurrency = qMax(1, matches);
+}
+
+void MatchArbiter::setMoveTime(int milliseconds) {
+    moveTime = qMax(1, milliseconds);
+}
+
+void MatchArbiter::setGamesPerMatch(int games) {
+    gamesPerMatch = qMax(1, games);
+}
+
+void MatchArbiter::setMoveLog(QStringList *log) {
+    moveLog = log;
+}
+
+void MatchArbiter::setRatingLadder(RatingLadder *ladder) {
+    ratingLadder = ladder;
+}
+
+void MatchArbiter::run(int games) {
+    // Matches of up to gamesPerMatch games; sides swap between matches too
+    struct Pending { int first, second, games; };
+    QVector<Pending> queue;
+    for (int a = 0; a < engines.size(); ++a) {
+        for (int b = a + 1; b < engines.size(); ++b) {
+            for (int played = 0, n = 0; played < games; played += gamesPerMatch, ++n) {
+                int count = qMin(gamesPerMatch, games - played);
+                queue.append(n % 2 ? Pending{b, a, count} : Pending{a, b, count});
+            }
+        }
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    QVector<ArbiterMatch *> active;
+    int next = 0;
+    QVector<pollfd> fds;
+    QVector<QPair<ArbiterMatch *, int>> owners;
+
+    while (next < queue.size() || !active.isEmpty()) {
+        while (active.size() < concurrency && next < queue.size()) {
+            const Pending &pending = queue[next++];
+            ArbiterMatch *match = new ArbiterMatch(pending.first, pending.second, rules, pending.games, moveTime);
+            match->start(engines, nowMicros());
+            active.append(match);
+        }
+
+        // Wait on every pipe that owes a reply, until the nearest deadline
+        fds.clear();
+        owners.clear();
+        qint64 nearest = -1;
+        for (ArbiterMatch *match : active) {
+            for (int side = 0; side < 2; ++side) {
+                if (match->isDone() || !match->isAwaiting(side)) continue;
+                fds.append(pollfd{match->readFd(side), POLLIN, 0});
+                owners.append(qMakePair(match, side));
+                if (nearest < 0 || match->deadline(side) < nearest) nearest = match->deadline(side);
+            }
+        }
+        if (!fds.isEmpty()) {
+            int wait = int(qBound<qint64>(0, (nearest - nowMicros() + 999) / 1000, moveTime));
+            if (poll(fds.data(), nfds_t(fds.size()), wait) < 0 && errno != EINTR) break;
+        }
+
+        qint64 now = nowMicros();
+        for (int i = 0; i < fds.size(); ++i) {
+            ArbiterMatch *match = owners[i].first;
+            int side = owners[i].second;
+            if (fds[i].revents != 0) match->onReadable(side, now);
+            if (!match->isDone() && match->isAwaiting(side) && now > match->deadline(side)) match->onTimeout(side);
+        }
+
+        // Finished engines get up to a move time to quit before they are
+        // killed, and are reaped as they exit rather than waited for here
+        for (int i = active.size() - 1; i >= 0; --i) {
+            collect(*active[i]);
+            if (!active[i]->isDone()) continue;
+            for (int pid : active[i]->stopEngines()) {
+                exiting.append(Exiting{pid, now + qint64(moveTime) * 1000, false});
+            }
+            delete active[i];
+            active.remove(i);
+        }
+        reap(now);
+    }
+
+    while (!exiting.isEmpty()) {
+        usleep(1000);
+        reap(nowMicros());
+    }
+}
+
+void MatchArbiter::reap(qint64 now) {
+    for (int i = exiting.size() - 1; i >= 0; --i) {
+        Exiting &engine = exiting[i];
+        pid_t reaped = waitpid(engine.pid, nullptr, WNOHANG);
+        if (reaped == engine.pid || (reaped < 0 && errno != EINTR)) {
+            exiting.remove(i);
+        } else if (!engine.killed && now > engine.deadline) {
+            kill(engine.pid, SIGKILL);
+            engine.killed = true;
+        }
+    }
+}
+
+void MatchArbiter::collect(ArbiterMatch &match) {
+    for (int side = 0; side < 2; ++side) {
+        for (qint64 micros : match.takeReplyTimes(side)) {
+            engineStats[match.engine(side)].replyLatency.record(micros * 1000);
+        }
+    }
+    for (const ArbiterMatch::GameRecord &game : match.takeFinished()) {
+        for (int side = 0; side < 2; ++side) engineStats[match.engine(side)].games++;
+        if (game.winner >= 0) {
+            int winner = match.engine(game.winner);
+            int loser = match.engine(1 - game.winner);
+            engineStats[winner].wins++;
+            if (game.reason.isEmpty()) {
+                engineStats[winner].fleetsSunk++;
+                engineStats[winner].winningShots += game.shots[game.winner];
+            } else {
+                engineStats[loser].forfeits++;
+            }
+            pairWins[winner][loser]++;
+        }
+        if (ratingLadder) {
+            ratingLadder->record(engines[match.engine(0)].name, engines[match.engine(1)].name,
+                                 game.winner < 0 ? 0.5 : game.winner == 0 ? 1.0 : 0.0);
+        }
+        if (moveLog) {
+            moveLog->append(QString("%1 vs %2 winner %3%4: %5")
+                                .arg(engines[match.engine(0)].name, engines[match.engine(1)].name)
+                                .arg(game.winner >= 0 ? engines[match.engine(game.winner)].name : QString("none"))
+                                .arg(game.reason.isEmpty() ? QString() : " (" + game.reason + ")")
+                                .arg(game.moves));
+        }
+    }
+}
+
+const ArbiterEngineStats &MatchArbiter::stats(int engine) const {
+    return engineStats[engine];
+}
+
+QString MatchArbiter::toText() const {
+    QString text;
+    for (int i = 0; i < engines.size(); ++i) {
+        const ArbiterEngineStats &s = engineStats[i];
+        double shotsToWin = s.fleetsSunk > 0 ? double(s.winningShots) / s.fleetsSunk : 0.0;
+        text += QString("%1: %2 games, %3 wins (%4%), %5 forfeits, %6 shots per win, reply p50 %7us p99 %8us max %9us\n")
+                    .arg(engines[i].name)
+                    .arg(s.games)
+                    .arg(s.wins)
+                    .arg(s.games ? 100.0 * s.wins / s.games : 0.0, 0, 'f', 1)
+                    .arg(s.forfeits)
+                    .arg(shotsToWin, 0, 'f', 2)
+                    .arg(s.replyLatency.percentile(50) / 1000)
+                    .arg(s.replyLatency.percentile(99) / 1000)
+                    .arg(s.replyLatency.max() / 1000);
+    }
+    for (int a = 0; a < engines.size(); ++a) {
+        for (int b = a + 1; b < engines.size(); ++b) {
+            text += QString("%1 vs %2: %3-%4\n").arg(engines[a].name, engines[b].name)
+                        .arg(pairWins[a][b]).arg(pairWins[b][a]);
+        }
+    }
+    return text;
+}
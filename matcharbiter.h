@@ -0,0 +1,152 @@
+#ifndef MATCHARBITER_H
+#define MATCHARBITER_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "board.h"
+#include "latencyprobe.h"
+#include "ratingladder.h"
+
+// Protocol engine run by the arbiter, as given on the command line.
+struct ArbiterEngine {
+    QString name;
+    QString command;
+};
+
+// Per-engine totals over every game the arbiter ran.
+struct ArbiterEngineStats {
+    int games = 0;
+    int wins = 0;
+    int forfeits = 0; // games lost on time, an illegal reply or a crash
+    int fleetsSunk = 0; // wins by sinking the whole fleet
+    qint64 winningShots = 0; // shots fired in those wins
+    LatencyHistogram replyLatency; // shot? to shot reply
+};
+
+// One engine process with non-blocking pipes to its stdin and stdout.
+class EnginePipe {
+public:
+    EnginePipe();
+    ~EnginePipe();
+    EnginePipe(const EnginePipe &) = delete;
+    EnginePipe &operator=(const EnginePipe &) = delete;
+
+    bool spawn(const QString &command);
+    bool send(const QString &line);
+    // Reads what is available; false on end of file or a read error.
+    bool fill();
+    bool takeLine(QString &line);
+    // Asks the engine to quit and closes the pipes without waiting. Returns
+    // the pid for the caller to reap, -1 if no engine was running.
+    int stop();
+    int readFd() const;
+
+private:
+    int pid;
+    int input;
+    int output;
+    QByteArray buffer;
+};
+
+// A series of games between two engine processes, advanced one reply at a
+// time so the arbiter can interleave hundreds of them. Side 0 fires first in
+// even games. A side that times out, breaks the protocol or dies loses the
+// game, and the rest of the match is abandoned.
+class ArbiterMatch {
+public:
+    ArbiterMatch(int first, int second, const RuleSet &rules, int games, int moveTimeMs);
+
+    bool start(const QVector<ArbiterEngine> &engines, qint64 now);
+    // Reads and handles whatever the side's engine sent. Times in microseconds.
+    void onReadable(int side, qint64 now);
+    void onTimeout(int side);
+
+    bool isDone() const;
+    bool isAwaiting(int side) const;
+    qint64 deadline(int side) const;
+    int readFd(int side) const;
+    int engine(int side) const;
+    // Asks both engines to quit; returns the pids still to reap.
+    QVector<int> stopEngines();
+
+    // Finished games since the last call, for the arbiter to tally and log.
+    struct GameRecord {
+        int winner;      // side
+        int shots[2];
+        QString reason;  // empty for a normal finish
+        QString moves;   // "0:C7h 1:D4m ..." with h/m/s for hit, miss, sunk
+    };
+    QVector<GameRecord> takeFinished();
+    QVector<qint64> takeReplyTimes(int side);
+
+private:
+    enum Phase { NewGame, Placing, Playing, Done };
+
+    int engines[2];
+    RuleSet rules;
+    int gamesLeft;
+    int gameIndex;
+    int moveTime;
+    Phase phase;
+    EnginePipe pipes[2];
+    Board boards[2]; // boards[side] holds that side's fleet
+    bool awaiting[2];
+    qint64 sentAt[2];
+    qint64 deadlines[2];
+    int toMove;
+    GameRecord current;
+    QVector<GameRecord> finished;
+    QVector<qint64> replyTimes[2];
+
+    void beginGame(qint64 now);
+    bool send(int side, const QString &line, qint64 now, bool expectReply = true);
+    void handleLine(int side, const QString &line, qint64 now);
+    bool placeFleet(int side, const QString &line);
+    void endGame(int winner, const QString &reason, qint64 now);
+    void forfeit(int side, const QString &reason);
+};
+
+// Runs every pairing of the engines over a pool of concurrent matches with a
+// single poll() loop over all their pipes.
+class MatchArbiter {
+public:
+    MatchArbiter(const QVector<ArbiterEngine> &engines, const RuleSet &rules);
+
+    void setConcurrency(int matches);
+    void setMoveTime(int milliseconds);
+    void setGamesPerMatch(int games);
+    void setMoveLog(QStringList *log);
+    // Records every finished game under the engines' names
+    void setRatingLadder(RatingLadder *ladder);
+
+    // `games` games for every unordered pair of engines.
+    void run(int games);
+
+    const ArbiterEngineStats &stats(int engine) const;
+    QString toText() const;
+
+private:
+    // Engine told to quit, reaped once it exits or killed at the deadline
+    struct Exiting {
+        int pid;
+        qint64 deadline;
+        bool killed;
+    };
+
+    QVector<ArbiterEngine> engines;
+    RuleSet rules;
+    int concurrency;
+    int moveTime;
+    int gamesPerMatch;
+    QStringList *moveLog;
+    RatingLadder *ratingLadder;
+    QVector<ArbiterEngineStats> engineStats;
+    QVector<QVector<int>> pairWins; // [winner][loser]
+    QVector<Exiting> exiting;
+
+    void collect(ArbiterMatch &match);
+    void reap(qint64 now);
+};
+
+#endif // MATCHARBITER_H
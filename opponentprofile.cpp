@@ -0,0 +1,131 @@
+#include "opponentprofile.h"
+#include "placementoptimizer.h"
+#include <QDataStream>
+#include <QFile>
+
+static const quint32 PROFILE_MAGIC = 0x4253504f; // "BSPO"
+static const quint16 PROFILE_VERSION = 1;
+// Pseudo-games of uniform behaviour mixed into the histograms, so one odd
+// game does not swing the bots
+static const double PRIOR_GAMES = 2.0;
+static const double FAVOURITE_RATIO = 1.5;
+
+OpponentProfile::OpponentProfile(int rows, int cols) : gridRows(rows), gridCols(cols) {
+    clear();
+}
+
+void OpponentProfile::clear() {
+    gameCount = 0;
+    horizontalShips = 0;
+    verticalShips = 0;
+    for (int cell = 0; cell < MAX_GRID_CELLS; ++cell) {
+        placements[cell] = 0;
+        shots[cell] = 0;
+    }
+}
+
+void OpponentProfile::recordGame(const Board &theirBoard, const QVector<int> &theirShots) {
+    const Fleet &fleet = theirBoard.fleet();
+    for (int id = 0; id < fleet.count; ++id) {
+        if (fleet.vertical[id]) verticalShips++;
+        else horizontalShips++;
+        int step = fleet.vertical[id] ? gridCols : 1;
+        int first = fleet.row[id] * gridCols + fleet.col[id];
+        for (int i = 0; i < fleet.length[id]; ++i) placements[first + i * step]++;
+    }
+
+    // Earlier shots weigh more; cells never fired at get nothing
+    int cells = gridRows * gridCols;
+    for (int turn = 0; turn < theirShots.size() && turn < cells; ++turn) {
+        shots[theirShots[turn]] += cells - turn;
+    }
+    gameCount++;
+}
+
+int OpponentProfile::rows() const {
+    return gridRows;
+}
+
+int OpponentProfile::cols() const {
+    return gridCols;
+}
+
+int OpponentProfile::games() const {
+    return gameCount;
+}
+
+bool OpponentProfile::isReady() const {
+    return gameCount >= MIN_GAMES;
+}
+
+CellMask OpponentProfile::favouriteCells(const RuleSet &rules) const {
+    CellMask favourites;
+    if (!isReady() || rules.rows != gridRows || rules.cols != gridCols) return favourites;
+
+    // Chance a uniform placer covers each cell in one game
+    QVector<double> density = PlacementOptimizer::densityModel(rules);
+    double fleetShare = double(rules.fleetCells()) / rules.cells();
+    for (int cell = 0; cell < rules.cells(); ++cell) {
+        double expected = density[cell] * fleetShare;
+        double observed = (placements[cell] + PRIOR_GAMES * expected) / (gameCount + PRIOR_GAMES);
+        if (observed > FAVOURITE_RATIO * expected) favourites.set(cell);
+    }
+    return favourites;
+}
+
+QVector<double> OpponentProfile::shotModel() const {
+    QVector<double> weights;
+    if (!isReady()) return weights;
+
+    int cells = gridRows * gridCols;
+    double total = 0;
+    for (int cell = 0; cell < cells; ++cell) total += shots[cell];
+    if (total == 0) return weights;
+
+    weights.resize(cells);
+    for (int cell = 0; cell < cells; ++cell) {
+        double observed = shots[cell] * cells / total;
+        weights[cell] = (gameCount * observed + PRIOR_GAMES) / (gameCount + PRIOR_GAMES);
+    }
+    return weights;
+}
+
+double OpponentProfile::verticalShare() const {
+    return (verticalShips + 1.0) / (horizontalShips + verticalShips + 2.0);
+}
+
+bool OpponentProfile::save(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << PROFILE_MAGIC << PROFILE_VERSION << gridRows << gridCols
+        << gameCount << horizontalShips << verticalShips;
+    for (int cell = 0; cell < gridRows * gridCols; ++cell) out << placements[cell] << shots[cell];
+    return out.status() == QDataStream::Ok;
+}
+
+bool OpponentProfile::load(const QString &path) {
+    clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint16 version, rows, cols;
+    in >> magic >> version >> rows >> cols;
+    if (in.status() != QDataStream::Ok || magic != PROFILE_MAGIC || version != PROFILE_VERSION
+        || rows != gridRows || cols != gridCols) {
+        return false;
+    }
+
+    in >> gameCount >> horizontalShips >> verticalShips;
+    for (int cell = 0; cell < gridRows * gridCols; ++cell) in >> placements[cell] >> shots[cell];
+    if (in.status() != QDataStream::Ok) {
+        clear();
+        return false;
+    }
+    return true;
+}
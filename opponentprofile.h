@@ -0,0 +1,54 @@
+#ifndef OPPONENTPROFILE_H
+#define OPPONENTPROFILE_H
+
+#include <QString>
+#include <QVector>
+#include "board.h"
+
+// What one opponent tends to do on one grid shape, accumulated over games:
+// how often they put a ship on each cell, how early they fire at each cell,
+// and how many of their ships lie vertical. Updated once per finished game
+// and stored as a small binary file (a few hundred bytes on a 10x10 grid).
+class OpponentProfile {
+public:
+    // Games needed before the bots trust the histograms
+    static const int MIN_GAMES = 3;
+
+    explicit OpponentProfile(int rows = 0, int cols = 0);
+
+    // theirBoard holds the opponent's fleet; theirShots the cells
+    // (row * cols + col) they fired at, in order.
+    void recordGame(const Board &theirBoard, const QVector<int> &theirShots);
+
+    int rows() const;
+    int cols() const;
+    int games() const;
+    bool isReady() const;
+
+    // Cells the opponent puts ships on clearly more often than a uniform
+    // placer would. Empty until isReady().
+    CellMask favouriteCells(const RuleSet &rules) const;
+    // Per-cell shot weight with mean 1 (how early they fire there), for
+    // PlacementOptimizer. Empty until isReady().
+    QVector<double> shotModel() const;
+    // Share of their ships placed vertically, 0.5 when nothing is known.
+    double verticalShare() const;
+
+    bool save(const QString &path) const;
+    // Fails, leaving the profile empty, if the file is missing, damaged or
+    // was recorded on another grid shape.
+    bool load(const QString &path);
+
+private:
+    quint16 gridRows;
+    quint16 gridCols;
+    quint32 gameCount;
+    quint32 horizontalShips;
+    quint32 verticalShips;
+    quint32 placements[MAX_GRID_CELLS]; // games with a ship on the cell
+    quint32 shots[MAX_GRID_CELLS];      // sum of (cells - turn) over shots at the cell
+
+    void clear();
+};
+
+#endif // OPPONENTPROFILE_H
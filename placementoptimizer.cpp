@@ -0,0 +1,192 @@
+#include "placementoptimizer.h"
+#include "enginerandom.h"
+#include "latencyprobe.h"
+#include "tracing.h"
+#include <cmath>
+
+// Cost of one touching cell, in units of an average cell's shot weight
+static const double TOUCH_PENALTY = 1.0;
+static const double START_TEMPERATURE = 2.0;
+// Where annealing stops: lower gives cheaper fleets that are easier to predict
+static const double SAMPLE_TEMPERATURE = 1.0;
+// Most fleets a cell may be in, as a multiple of the average cell's share
+static const double OCCUPANCY_LIMIT = 1.2;
+static const int LIMIT_ROUNDS = 3;
+static const int LIMIT_STEPS = 5000;
+
+PlacementOptimizer::PlacementOptimizer(const RuleSet &rules) : rules(rules), limited(false), cost(0) {
+    for (int shipLength : rules.shipLengths) {
+        positions.append(shipPositions(rules, shipLength));
+        QVector<CellMask> shipHalos;
+        for (const CellMask &ship : positions.last()) {
+            CellMask halo;
+            for (int cell = 0; cell < rules.cells(); ++cell) {
+                if (!ship.test(cell)) continue;
+                int row = cell / rules.cols;
+                int col = cell % rules.cols;
+                if (row > 0) halo.set(cell - rules.cols);
+                if (row + 1 < rules.rows) halo.set(cell + rules.cols);
+                if (col > 0) halo.set(cell - 1);
+                if (col + 1 < rules.cols) halo.set(cell + 1);
+            }
+            shipHalos.append(halo & ~ship);
+        }
+        halos.append(shipHalos);
+    }
+    setShotModel(densityModel(rules));
+}
+
+QVector<double> PlacementOptimizer::densityModel(const RuleSet &rules) {
+    QVector<double> weights(rules.cells(), 0.0);
+    double total = 0;
+    for (int shipLength : rules.shipLengths) {
+        for (const CellMask &ship : shipPositions(rules, shipLength)) {
+            for (int cell = 0; cell < rules.cells(); ++cell) {
+                if (ship.test(cell)) {
+                    weights[cell] += 1;
+                    total += 1;
+                }
+            }
+        }
+    }
+    // Scale to an average of 1 per cell
+    for (double &weight : weights) weight *= rules.cells() / total;
+    return weights;
+}
+
+void PlacementOptimizer::setShotModel(const QVector<double> &model) {
+    weights.resize(rules.cells());
+    for (int cell = 0; cell < rules.cells(); ++cell) weights[cell] = model.value(cell, 1.0);
+    updateRates();
+    limited = false;
+}
+
+void PlacementOptimizer::updateRates() {
+    rates.clear();
+    for (const QVector<CellMask> &shipPositions : positions) {
+        QVector<double> shipRates;
+        for (const CellMask &ship : shipPositions) {
+            double rate = 0;
+            for (int cell = 0; cell < rules.cells(); ++cell) {
+                if (ship.test(cell)) rate += weights[cell];
+            }
+            shipRates.append(rate);
+        }
+        rates.append(shipRates);
+    }
+}
+
+// Samples fleets at SAMPLE_TEMPERATURE and, for every cell in more of them
+// than the limit allows, adds the weight that scales its Boltzmann factor by
+// limit / occupancy. Penalties interact, so this repeats a few rounds.
+void PlacementOptimizer::limitOccupancy() {
+    LATENCY_PROBE("placement.limit");
+    int fleetCells = 0;
+    for (int shipLength : rules.shipLengths) fleetCells += shipLength;
+    double limit = OCCUPANCY_LIMIT * fleetCells / rules.cells();
+
+    QVector<int> chosen;
+    CellMask fleet;
+    randomFleet(chosen, fleet);
+    for (int round = 0; round < LIMIT_ROUNDS; ++round) {
+        QVector<QVector<int>> visits;
+        for (const QVector<CellMask> &shipPositions : positions) visits.append(QVector<int>(shipPositions.size(), 0));
+        anneal(chosen, fleet, LIMIT_STEPS, SAMPLE_TEMPERATURE, SAMPLE_TEMPERATURE, &visits);
+
+        QVector<double> occupancy(rules.cells(), 0.0);
+        for (int i = 0; i < positions.size(); ++i) {
+            for (int p = 0; p < positions[i].size(); ++p) {
+                if (visits[i][p] == 0) continue;
+                for (int cell = 0; cell < rules.cells(); ++cell) {
+                    if (positions[i][p].test(cell)) occupancy[cell] += double(visits[i][p]) / LIMIT_STEPS;
+                }
+            }
+        }
+        bool changed = false;
+        for (int cell = 0; cell < rules.cells(); ++cell) {
+            if (occupancy[cell] <= limit) continue;
+            weights[cell] += SAMPLE_TEMPERATURE * std::log(occupancy[cell] / limit);
+            changed = true;
+        }
+        if (!changed) break;
+        updateRates();
+    }
+    limited = true;
+}
+
+// A uniformly random legal fleet
+void PlacementOptimizer::randomFleet(QVector<int> &chosen, CellMask &fleet) const {
+    int ships = positions.size();
+    chosen.resize(ships);
+    fleet = CellMask();
+    for (int i = 0; i < ships; ++i) {
+        do {
+            chosen[i] = engineRandom(positions[i].size());
+        } while (!(positions[i][chosen[i]] & fleet).isEmpty());
+        fleet |= positions[i][chosen[i]];
+    }
+}
+
+double PlacementOptimizer::fleetCost(const QVector<int> &chosen, const CellMask &fleet) const {
+    double total = 0;
+    for (int i = 0; i < positions.size(); ++i) {
+        CellMask others = fleet & ~positions[i][chosen[i]];
+        total += rates[i][chosen[i]] + touching(halos[i][chosen[i]], others) / 2;
+    }
+    return total;
+}
+
+// Moves one ship at a time, accepting worse fleets with the Metropolis rule,
+// as the temperature goes geometrically from `from` to `to`. If `visits` is
+// given, it counts the steps each position spent in the fleet.
+void PlacementOptimizer::anneal(QVector<int> &chosen, CellMask &fleet, int steps, double from, double to,
+                                QVector<QVector<int>> *visits) {
+    int ships = positions.size();
+    double cooling = std::pow(to / from, 1.0 / qMax(1, steps));
+    double temperature = from;
+    for (int step = 0; step < steps; ++step, temperature *= cooling) {
+        if (visits) {
+            for (int i = 0; i < ships; ++i) (*visits)[i][chosen[i]]++;
+        }
+        int i = engineRandom(ships);
+        int candidate = engineRandom(positions[i].size());
+        CellMask others = fleet & ~positions[i][chosen[i]];
+        if (!(positions[i][candidate] & others).isEmpty()) continue;
+
+        double delta = rates[i][candidate] - rates[i][chosen[i]]
+                       + touching(halos[i][candidate], others) - touching(halos[i][chosen[i]], others);
+        if (delta > 0 && engineRandom(1 << 20) >= std::exp(-delta / temperature) * (1 << 20)) continue;
+
+        chosen[i] = candidate;
+        fleet = others | positions[i][candidate];
+        cost += delta;
+    }
+}
+
+double PlacementOptimizer::touching(const CellMask &halo, const CellMask &others) const {
+    return TOUCH_PENALTY * (halo & others).count();
+}
+
+void PlacementOptimizer::place(Board &board, int iterations) {
+    if (!limited) limitOccupancy();
+    LATENCY_PROBE("placement.anneal");
+    TRACE_SPAN("bot", "placement.anneal");
+    QVector<int> chosen;
+    CellMask fleet;
+    randomFleet(chosen, fleet);
+    cost = fleetCost(chosen, fleet);
+    anneal(chosen, fleet, iterations, START_TEMPERATURE, SAMPLE_TEMPERATURE, nullptr);
+
+    for (int i = 0; i < positions.size(); ++i) {
+        const CellMask &ship = positions[i][chosen[i]];
+        int first = ship.select(0);
+        int row = first / rules.cols;
+        int col = first % rules.cols;
+        bool isVertical = rules.shipLengths[i] > 1 && first + rules.cols < rules.cells() && ship.test(first + rules.cols);
+        board.placeShip(row, col, isVertical, rules.shipLengths[i]);
+    }
+}
+
+double PlacementOptimizer::lastCost() const {
+    return cost;
+}
@@ -0,0 +1,47 @@
+#ifndef PLACEMENTOPTIMIZER_H
+#define PLACEMENTOPTIMIZER_H
+
+#include <QVector>
+#include "board.h"
+
+// Picks a fleet that a given opponent should take long to find. The opponent
+// is modelled as a per-cell shot weight (how early they tend to fire there);
+// a ship's discovery rate is the sum of the weights under it. Simulated
+// annealing over ship positions favours fleets with a low total rate, plus a
+// penalty for ships touching, since finishing one then uncovers the other.
+// It cools only down to a sampling temperature, so each game draws a fresh
+// fleet instead of the same near-optimal cells. Cells the sampler would still
+// fill too often (the corners, against a density hunter) get extra weight
+// until no cell is in much more than the average share of fleets.
+class PlacementOptimizer {
+public:
+    static const int DEFAULT_ITERATIONS = 20000;
+
+    explicit PlacementOptimizer(const RuleSet &rules);
+
+    // Shot model of a density hunter: how many ship positions cover each cell.
+    static QVector<double> densityModel(const RuleSet &rules);
+
+    void setShotModel(const QVector<double> &model);
+    void place(Board &board, int iterations = DEFAULT_ITERATIONS);
+    double lastCost() const;
+
+private:
+    RuleSet rules;
+    QVector<QVector<CellMask>> positions;  // per ship, every position
+    QVector<QVector<CellMask>> halos;      // cells orthogonally next to each position
+    QVector<double> weights;               // shot model plus occupancy penalties, per cell
+    QVector<QVector<double>> rates;        // weight under each position
+    bool limited;                          // penalties calibrated for the current shot model
+    double cost;
+
+    void updateRates();
+    void limitOccupancy();
+    void randomFleet(QVector<int> &chosen, CellMask &fleet) const;
+    double fleetCost(const QVector<int> &chosen, const CellMask &fleet) const;
+    void anneal(QVector<int> &chosen, CellMask &fleet, int steps, double from, double to,
+                QVector<QVector<int>> *visits);
+    double touching(const CellMask &halo, const CellMask &others) const;
+};
+
+#endif // PLACEMENTOPTIMIZER_H
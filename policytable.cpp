@@ -0,0 +1,204 @@
+#include "policytable.h"
+#include <QDataStream>
+#include <QFile>
+#include <algorithm>
+#include <functional>
+
+namespace {
+const quint32 TABLE_MAGIC = 0x42535054; // "BSPT"
+const quint16 TABLE_VERSION = 2;
+}
+
+SolverKey SolverKey::fromBoard(const Board &target, const QVector<int> &shipLengths) {
+    SolverKey key = {0, 0, 0, 0};
+    CellMask untried = target.untriedMask();
+    int cols = target.cols();
+    for (int cell = 0; cell < target.cells(); ++cell) {
+        if (untried.test(cell)) continue;
+        int row = cell / cols;
+        int col = cell % cols;
+        quint64 bit = quint64(1) << cell;
+        if (target.shipAt(row, col) < 0) {
+            key.misses |= bit;
+        } else {
+            key.hits |= bit;
+            if (target.isSunkAt(row, col)) key.sunk |= bit;
+        }
+    }
+    const Fleet &fleet = target.fleet();
+    for (int ship = 0; ship < fleet.count; ++ship) {
+        if (target.isShipSunk(ship)) {
+            key.sunkShips = markSunk(key.sunkShips, shipLengths, fleet.length[ship]);
+        }
+    }
+    return key;
+}
+
+quint16 SolverKey::markSunk(quint16 sunkShips, const QVector<int> &shipLengths, int length) {
+    for (int ship = 0; ship < shipLengths.size(); ++ship) {
+        quint16 bit = quint16(1) << ship;
+        if (shipLengths[ship] == length && !(sunkShips & bit)) return sunkShips | bit;
+    }
+    return sunkShips;
+}
+
+// Symmetry bits: 1 flips the rows, 2 the columns, 4 transposes (square grids only)
+GridSymmetry::GridSymmetry(int rows, int cols) : symmetries(rows == cols ? 8 : 4) {
+    int cells = rows * cols;
+    for (int symmetry = 0; symmetry < symmetries; ++symmetry) {
+        for (int cell = 0; cell < cells && cell < 64; ++cell) {
+            int row = cell / cols;
+            int col = cell % cols;
+            if (symmetry & 1) row = rows - 1 - row;
+            if (symmetry & 2) col = cols - 1 - col;
+            if (symmetry & 4) qSwap(row, col);
+            int image = row * cols + col;
+            forward[symmetry][cell] = image;
+            backward[symmetry][image] = cell;
+        }
+    }
+}
+
+int GridSymmetry::count() const {
+    return symmetries;
+}
+
+quint64 GridSymmetry::apply(int symmetry, quint64 mask) const {
+    quint64 image = 0;
+    while (mask) {
+        image |= quint64(1) << forward[symmetry][qCountTrailingZeroBits(mask)];
+        mask &= mask - 1;
+    }
+    return image;
+}
+
+int GridSymmetry::applyToCell(int symmetry, int cell) const {
+    return forward[symmetry][cell];
+}
+
+int GridSymmetry::invertCell(int symmetry, int cell) const {
+    return backward[symmetry][cell];
+}
+
+SolverKey GridSymmetry::canonical(const SolverKey &key, int &symmetry) const {
+    SolverKey best = key;
+    symmetry = 0;
+    for (int candidate = 1; candidate < symmetries; ++candidate) {
+        SolverKey image = {apply(candidate, key.hits), apply(candidate, key.misses), apply(candidate, key.sunk),
+                           key.sunkShips};
+        bool less = image.hits != best.hits ? image.hits < best.hits
+                    : image.misses != best.misses ? image.misses < best.misses
+                    : image.sunk < best.sunk;
+        if (less) {
+            best = image;
+            symmetry = candidate;
+        }
+    }
+    return best;
+}
+
+PolicyTable::PolicyTable() : expected(0) {
+}
+
+bool PolicyTable::isEmpty() const {
+    return moves.isEmpty();
+}
+
+int PolicyTable::size() const {
+    return moves.size();
+}
+
+const RuleSet &PolicyTable::rules() const {
+    return tableRules;
+}
+
+double PolicyTable::expectedShots() const {
+    return expected;
+}
+
+bool PolicyTable::lookup(const Board &target, int &row, int &col) const {
+    if (moves.isEmpty() || target.rows() != tableRules.rows || target.cols() != tableRules.cols
+        || target.fleet().count != tableRules.shipCount()) {
+        return false;
+    }
+    // A table solved for other ship lengths would play moves that mean nothing here
+    const Fleet &fleet = target.fleet();
+    quint8 lengths[MAX_SHIPS];
+    std::copy(fleet.length, fleet.length + fleet.count, lengths);
+    std::sort(lengths, lengths + fleet.count, std::greater<int>());
+    for (int ship = 0; ship < fleet.count; ++ship) {
+        if (lengths[ship] != tableRules.shipLengths[ship]) return false;
+    }
+
+    int mapping;
+    SolverKey key = symmetry.canonical(SolverKey::fromBoard(target, tableRules.shipLengths), mapping);
+    auto move = moves.constFind(key);
+    if (move == moves.constEnd()) return false;
+    int cell = symmetry.invertCell(mapping, *move);
+    row = cell / tableRules.cols;
+    col = cell % tableRules.cols;
+    return true;
+}
+
+bool PolicyTable::save(const QString &path) const {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << TABLE_MAGIC << TABLE_VERSION << quint16(tableRules.rows) << quint16(tableRules.cols)
+        << quint8(tableRules.shipCount());
+    for (int length : tableRules.shipLengths) out << quint8(length);
+    out << expected << quint32(moves.size());
+    for (auto move = moves.constBegin(); move != moves.constEnd(); ++move) {
+        out << move.key().hits << move.key().misses << move.key().sunk << move.key().sunkShips << *move;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+bool PolicyTable::load(const QString &path) {
+    clear();
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic;
+    quint16 version, rows, cols;
+    quint8 ships;
+    in >> magic >> version >> rows >> cols >> ships;
+    if (in.status() != QDataStream::Ok || magic != TABLE_MAGIC || version != TABLE_VERSION
+        || rows * cols > 64 || ships > MAX_SHIPS) {
+        return false;
+    }
+
+    tableRules.rows = rows;
+    tableRules.cols = cols;
+    tableRules.shipLengths.clear();
+    for (int i = 0; i < ships; ++i) {
+        quint8 length;
+        in >> length;
+        tableRules.shipLengths.append(length);
+    }
+    quint32 entries;
+    in >> expected >> entries;
+    for (quint32 i = 0; i < entries && in.status() == QDataStream::Ok; ++i) {
+        SolverKey key;
+        quint8 cell;
+        in >> key.hits >> key.misses >> key.sunk >> key.sunkShips >> cell;
+        moves.insert(key, cell);
+    }
+    if (in.status() != QDataStream::Ok || !tableRules.isValid()) {
+        clear();
+        return false;
+    }
+    symmetry = GridSymmetry(rows, cols);
+    return true;
+}
+
+void PolicyTable::clear() {
+    tableRules = RuleSet();
+    symmetry = GridSymmetry();
+    expected = 0;
+    moves.clear();
+}
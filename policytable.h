@@ -0,0 +1,83 @@
+#ifndef POLICYTABLE_H
+#define POLICYTABLE_H
+
+#include <QHash>
+#include <QString>
+#include "board.h"
+
+// What the shooter knows about a small board (at most 64 cells, bit
+// row * cols + col): cells hit, cells missed, the cells of ships sunk, and
+// which ships those were. The sunk cells alone are not enough: a 3-ship on
+// C1-E1 covers the same cells as a 1-ship on C1 and a 2-ship on D1-E1.
+struct SolverKey {
+    quint64 hits;
+    quint64 misses;
+    quint64 sunk;
+    quint16 sunkShips; // bit i: the rules' ship i (longest first) is sunk
+
+    static SolverKey fromBoard(const Board &target, const QVector<int> &shipLengths);
+    // Ships of one length look alike to the shooter, so sinking one takes the
+    // lowest clear bit among them.
+    static quint16 markSunk(quint16 sunkShips, const QVector<int> &shipLengths, int length);
+    bool operator==(const SolverKey &other) const {
+        return hits == other.hits && misses == other.misses && sunk == other.sunk && sunkShips == other.sunkShips;
+    }
+};
+
+inline size_t qHash(const SolverKey &key, size_t seed = 0) {
+    quint64 mixed = key.hits * 0x9E3779B97F4A7C15ull ^ key.misses * 0xC2B2AE3D27D4EB4Full
+                    ^ key.sunk * 0x165667B19E3779F9ull ^ key.sunkShips * 0x27D4EB2F165667C5ull;
+    return size_t(mixed ^ (mixed >> 29)) ^ seed;
+}
+
+// Flips (and, on square grids, the transpose) of the grid. States that are
+// mirror images of each other have the same value, so memo and table keys
+// are stored in their canonical form: the least image under any symmetry.
+class GridSymmetry {
+public:
+    explicit GridSymmetry(int rows = 0, int cols = 0);
+
+    int count() const;
+    quint64 apply(int symmetry, quint64 mask) const;
+    int applyToCell(int symmetry, int cell) const;
+    int invertCell(int symmetry, int cell) const;
+    // Canonical form of key; `symmetry` is the one that maps key onto it.
+    SolverKey canonical(const SolverKey &key, int &symmetry) const;
+
+private:
+    int symmetries;
+    quint8 forward[8][64];
+    quint8 backward[8][64];
+};
+
+// Optimal shot for every state on the optimal policy tree, as exported by
+// ExactSolver. A bot following it needs one hash lookup per shot.
+class PolicyTable {
+public:
+    PolicyTable();
+
+    bool isEmpty() const;
+    int size() const;
+    const RuleSet &rules() const;
+    // Expected shots to sink a uniformly placed fleet when following the table
+    double expectedShots() const;
+
+    // False if the table is for another grid or fleet, or has no entry for the state.
+    bool lookup(const Board &target, int &row, int &col) const;
+
+    bool save(const QString &path) const;
+    // Fails, leaving the table empty, if the file is missing or damaged.
+    bool load(const QString &path);
+
+private:
+    friend class ExactSolver;
+
+    RuleSet tableRules;
+    GridSymmetry symmetry;
+    double expected;
+    QHash<SolverKey, quint8> moves; // canonical state -> canonical cell
+
+    void clear();
+};
+
+#endif // POLICYTABLE_H
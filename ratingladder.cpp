@@ -0,0 +1,274 @@
+#include "ratingladder.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QtMath>
+#include <algorithm>
+
+namespace {
+const quint32 LOG_MAGIC = 0x4253524c; // "BSRL"
+const quint32 SNAPSHOT_MAGIC = 0x42535253; // "BSRS"
+const quint16 LADDER_VERSION = 1;
+const qint64 HEADER_SIZE = 4 + 2 + 8;
+
+enum RecordKind : quint8 { PlayerRecord, GameRecord };
+
+const double ELO_K = 8;
+const double INITIAL_DEVIATION = 350;
+// Deviation regained before every game, so a player's rating keeps following
+// its results (about 20 points of RD at equilibrium) instead of freezing
+const double DEVIATION_DRIFT = 1;
+const double GLICKO_Q = 0.0057564627324851; // ln(10) / 400
+
+double glickoWeight(double deviation) {
+    return 1.0 / qSqrt(1.0 + 3.0 * GLICKO_Q * GLICKO_Q * deviation * deviation / (M_PI * M_PI));
+}
+}
+
+RatingLadder::RatingLadder() : logId(0), gameCount(0) {
+}
+
+RatingLadder::~RatingLadder() {
+    close();
+}
+
+bool RatingLadder::open(const QString &path) {
+    close();
+    ratings.clear();
+    index.clear();
+    gameCount = 0;
+
+    log.setFileName(path);
+    if (!log.open(QIODevice::ReadWrite)) return false;
+
+    QDataStream stream(&log);
+    stream.setVersion(QDataStream::Qt_5_0);
+    if (log.size() == 0) {
+        logId = quint64(QDateTime::currentMSecsSinceEpoch());
+        stream << LOG_MAGIC << LADDER_VERSION << logId;
+        if (stream.status() != QDataStream::Ok || !log.flush()) {
+            log.close();
+            return false;
+        }
+    } else {
+        quint32 magic;
+        quint16 version;
+        stream >> magic >> version >> logId;
+        if (stream.status() != QDataStream::Ok || magic != LOG_MAGIC || version != LADDER_VERSION) {
+            log.close();
+            return false;
+        }
+    }
+
+    qint64 covered;
+    if (!loadSnapshot(covered)) {
+        ratings.clear();
+        index.clear();
+        gameCount = 0;
+        covered = HEADER_SIZE;
+    }
+    if (!replay(covered)) {
+        log.close();
+        return false;
+    }
+    return log.seek(log.size());
+}
+
+bool RatingLadder::close() {
+    if (!log.isOpen()) return true;
+    bool saved = log.flush() && saveSnapshot();
+    log.close();
+    return saved;
+}
+
+bool RatingLadder::isOpen() const {
+    return log.isOpen();
+}
+
+// Applies the log from byte `from` to the end. A record that stops short is
+// what a crash mid-write leaves, so it is cut off rather than failing.
+bool RatingLadder::replay(qint64 from) {
+    if (!log.seek(from)) return false;
+    QDataStream in(&log);
+    in.setVersion(QDataStream::Qt_5_0);
+    while (!in.atEnd()) {
+        qint64 start = log.pos();
+        quint8 kind;
+        in >> kind;
+        if (kind == PlayerRecord) {
+            QString name;
+            in >> name;
+            if (in.status() != QDataStream::Ok) return log.resize(start);
+            addPlayer(name);
+        } else if (kind == GameRecord) {
+            quint16 first, second;
+            quint8 doubledScore;
+            in >> first >> second >> doubledScore;
+            if (in.status() != QDataStream::Ok) return log.resize(start);
+            if (first >= ratings.size() || second >= ratings.size() || first == second || doubledScore > 2) return false;
+            update(first, second, doubledScore / 2.0);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RatingLadder::record(const QString &first, const QString &second, double score) {
+    if (!log.isOpen() || first == second) return false;
+
+    QDataStream out(&log);
+    out.setVersion(QDataStream::Qt_5_0);
+    int players[2];
+    const QString *names[2] = {&first, &second};
+    for (int side = 0; side < 2; ++side) {
+        players[side] = index.value(*names[side], -1);
+        if (players[side] < 0) {
+            if (ratings.size() > 0xffff) return false;
+            players[side] = addPlayer(*names[side]);
+            out << quint8(PlayerRecord) << *names[side];
+        }
+    }
+    quint8 doubledScore = quint8(qBound(0, qRound(score * 2), 2));
+    out << quint8(GameRecord) << quint16(players[0]) << quint16(players[1]) << doubledScore;
+    update(players[0], players[1], doubledScore / 2.0);
+    return out.status() == QDataStream::Ok;
+}
+
+quint64 RatingLadder::games() const {
+    return gameCount;
+}
+
+int RatingLadder::players() const {
+    return ratings.size();
+}
+
+int RatingLadder::player(const QString &name) const {
+    return index.value(name, -1);
+}
+
+const RatingLadder::Rating &RatingLadder::rating(int player) const {
+    return ratings[player];
+}
+
+double RatingLadder::expectedScore(int a, int b) const {
+    return 1.0 / (1.0 + qPow(10.0, (ratings[b].elo - ratings[a].elo) / 400.0));
+}
+
+QVector<RatingLadder::Rating> RatingLadder::leaderboard(bool byElo) const {
+    QVector<Rating> board = ratings;
+    std::sort(board.begin(), board.end(), [byElo](const Rating &a, const Rating &b) {
+        return byElo ? a.elo > b.elo : a.glicko > b.glicko;
+    });
+    return board;
+}
+
+QString RatingLadder::toText(bool byElo) const {
+    QVector<Rating> board = leaderboard(byElo);
+    QString text = QString("ladder: %1 games, %2 players\n").arg(gameCount).arg(board.size());
+    for (int i = 0; i < board.size(); ++i) {
+        const Rating &r = board[i];
+        QString gap;
+        if (i + 1 < board.size()) {
+            double below = byElo ? board[i + 1].elo : board[i + 1].glicko;
+            gap = QString(", %1 above the next").arg((byElo ? r.elo : r.glicko) - below, 0, 'f', 0);
+        }
+        text += QString("%1. %2: glicko %3 +/- %4, elo %5, %6 games, %7% won%8\n")
+                    .arg(i + 1)
+                    .arg(r.name)
+                    .arg(r.glicko, 0, 'f', 0)
+                    .arg(2 * r.deviation, 0, 'f', 0)
+                    .arg(r.elo, 0, 'f', 0)
+                    .arg(r.games)
+                    .arg(r.games ? 100.0 * (r.wins + 0.5 * r.draws) / r.games : 0.0, 0, 'f', 1)
+                    .arg(gap);
+    }
+    return text;
+}
+
+int RatingLadder::addPlayer(const QString &name) {
+    Rating rating;
+    rating.name = name;
+    index.insert(name, ratings.size());
+    ratings.append(rating);
+    return ratings.size() - 1;
+}
+
+// Elo with a fixed K, and Glicko with every game as its own rating period.
+// Both sides are updated from their ratings before the game.
+void RatingLadder::update(int first, int second, double score) {
+    Rating &a = ratings[first];
+    Rating &b = ratings[second];
+    gameCount++;
+    a.games++;
+    b.games++;
+    if (score > 0.75) a.wins++;
+    else if (score < 0.25) b.wins++;
+    else {
+        a.draws++;
+        b.draws++;
+    }
+
+    double expected = 1.0 / (1.0 + qPow(10.0, (b.elo - a.elo) / 400.0));
+    a.elo += ELO_K * (score - expected);
+    b.elo -= ELO_K * (score - expected);
+
+    double deviations[2] = {
+        qMin(INITIAL_DEVIATION, qSqrt(a.deviation * a.deviation + DEVIATION_DRIFT * DEVIATION_DRIFT)),
+        qMin(INITIAL_DEVIATION, qSqrt(b.deviation * b.deviation + DEVIATION_DRIFT * DEVIATION_DRIFT))};
+    double before[2] = {a.glicko, b.glicko};
+    double scores[2] = {score, 1.0 - score};
+    Rating *sides[2] = {&a, &b};
+    for (int side = 0; side < 2; ++side) {
+        double weight = glickoWeight(deviations[1 - side]);
+        double e = 1.0 / (1.0 + qPow(10.0, -weight * (before[side] - before[1 - side]) / 400.0));
+        double precision = 1.0 / (deviations[side] * deviations[side])
+                           + GLICKO_Q * GLICKO_Q * weight * weight * e * (1.0 - e);
+        sides[side]->glicko = before[side] + GLICKO_Q / precision * weight * (scores[side] - e);
+        sides[side]->deviation = qSqrt(1.0 / precision);
+    }
+}
+
+// The snapshot holds the ratings after the first `covered` bytes of the log.
+// It is ignored if it belongs to another log or covers more than is there.
+bool RatingLadder::loadSnapshot(qint64 &covered) {
+    QFile file(snapshotPath());
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_0);
+    quint32 magic, players;
+    quint16 version;
+    quint64 id, bytes;
+    in >> magic >> version >> id >> bytes >> gameCount >> players;
+    if (in.status() != QDataStream::Ok || magic != SNAPSHOT_MAGIC || version != LADDER_VERSION || id != logId
+        || bytes < quint64(HEADER_SIZE) || bytes > quint64(log.size()) || players > 0x10000) {
+        return false;
+    }
+    for (quint32 i = 0; i < players && in.status() == QDataStream::Ok; ++i) {
+        QString name;
+        in >> name;
+        Rating &rating = ratings[addPlayer(name)];
+        in >> rating.games >> rating.wins >> rating.draws >> rating.elo >> rating.glicko >> rating.deviation;
+    }
+    if (in.status() != QDataStream::Ok) return false;
+    covered = qint64(bytes);
+    return true;
+}
+
+bool RatingLadder::saveSnapshot() const {
+    QFile file(snapshotPath());
+    if (!file.open(QIODevice::WriteOnly)) return false;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_0);
+    out << SNAPSHOT_MAGIC << LADDER_VERSION << logId << quint64(log.size()) << gameCount << quint32(ratings.size());
+    for (const Rating &rating : ratings) {
+        out << rating.name << rating.games << rating.wins << rating.draws << rating.elo << rating.glicko
+            << rating.deviation;
+    }
+    return out.status() == QDataStream::Ok;
+}
+
+QString RatingLadder::snapshotPath() const {
+    return log.fileName() + ".ratings";
+}
@@ -0,0 +1,70 @@
+#ifndef RATINGLADDER_H
+#define RATINGLADDER_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+// Elo and Glicko ratings for named players (bot configurations such as
+// "Hard 10x10:5,4,3,3,2" or arbiter engines), updated one game at a time.
+//
+// Every result is appended to a log file, which is the source of truth. A
+// snapshot of the ratings beside it (<log>.ratings) records how much of the
+// log it covers, so opening a ladder replays only the games added since, and
+// leaderboards are read straight from the ratings in memory.
+class RatingLadder {
+public:
+    struct Rating {
+        QString name;
+        quint64 games = 0;
+        quint64 wins = 0;
+        quint64 draws = 0;
+        double elo = 1500;
+        double glicko = 1500;
+        double deviation = 350; // Glicko RD
+    };
+
+    RatingLadder();
+    ~RatingLadder();
+    RatingLadder(const RatingLadder &) = delete;
+    RatingLadder &operator=(const RatingLadder &) = delete;
+
+    // Creates the log if it is missing. Fails if it is not a ladder log; a
+    // record cut short by a crash is dropped from its end.
+    bool open(const QString &path);
+    // Flushes the log and writes the snapshot.
+    bool close();
+    bool isOpen() const;
+
+    // score is the first player's: 1 for a win, 0.5 for a draw, 0 for a loss.
+    // Unknown names join the ladder at the default ratings.
+    bool record(const QString &first, const QString &second, double score);
+
+    quint64 games() const;
+    int players() const;
+    int player(const QString &name) const; // -1 if unknown
+    const Rating &rating(int player) const;
+    // Chance that a beats b by Elo, for checking the gaps between labels
+    double expectedScore(int a, int b) const;
+
+    // Best first, by Glicko rating or by Elo
+    QVector<Rating> leaderboard(bool byElo = false) const;
+    QString toText(bool byElo = false) const;
+
+private:
+    QFile log;
+    quint64 logId; // creation time, so a snapshot is never applied to another log
+    quint64 gameCount;
+    QVector<Rating> ratings;
+    QHash<QString, int> index;
+
+    bool replay(qint64 from);
+    int addPlayer(const QString &name);
+    void update(int first, int second, double score);
+    bool loadSnapshot(qint64 &covered);
+    bool saveSnapshot() const;
+    QString snapshotPath() const;
+};
+
+#endif // RATINGLADDER_H
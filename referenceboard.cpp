@@ -0,0 +1,83 @@
+#include "referenceboard.h"
+
+ReferenceBoard::ReferenceBoard(int rows, int cols) : gridRows(rows), gridCols(cols) {
+    grid = QVector<QVector<char>>(rows, QVector<char>(cols, '~'));
+}
+
+bool ReferenceBoard::isValidPosition(int row, int col, bool isVertical, int shipLength) {
+    if (isVertical) {
+        if (row + shipLength > gridRows) return false;
+        for (int i = 0; i < shipLength; i++) {
+            if (grid[row + i][col] != '~') return false;
+        }
+    } else {
+        if (col + shipLength > gridCols) return false;
+        for (int i = 0; i < shipLength; i++) {
+            if (grid[row][col + i] != '~') return false;
+        }
+    }
+    return true;
+}
+
+void ReferenceBoard::placeShip(int row, int col, bool isVertical, int shipLength, char symbol) {
+    ReferenceShip ship = {row, col, isVertical, shipLength, {}};
+    if (isVertical) {
+        for (int i = 0; i < shipLength; i++) {
+            grid[row + i][col] = symbol;
+            ship.positions.append(qMakePair(row + i, col));
+        }
+    } else {
+        for (int i = 0; i < shipLength; i++) {
+            grid[row][col + i] = symbol;
+            ship.positions.append(qMakePair(row, col + i));
+        }
+    }
+    ships.append(ship);
+}
+
+bool ReferenceBoard::attack(int row, int col) {
+    if (grid[row][col] == 'S') {
+        grid[row][col] = 'X';
+        return true;
+    } else if (grid[row][col] == '~') {
+        grid[row][col] = 'O';
+    }
+    return false;
+}
+
+bool ReferenceBoard::hasShipsRemaining() {
+    for (const auto& row : grid) {
+        for (const auto& cell : row) {
+            if (cell == 'S') return true;
+        }
+    }
+    return false;
+}
+
+char ReferenceBoard::getCell(int row, int col) const {
+    return grid[row][col];
+}
+
+bool ReferenceBoard::isSunkAt(int row, int col) const {
+    for (const auto& ship : ships) {
+        if (!ship.positions.contains(qMakePair(row, col))) continue;
+        for (const auto& pos : ship.positions) {
+            if (grid[pos.first][pos.second] != 'X') return false;
+        }
+        return true;
+    }
+    return false;
+}
+
+int ReferenceBoard::smallestShipRemaining() const {
+    int smallest = 0;
+    for (const auto& ship : ships) {
+        for (const auto& pos : ship.positions) {
+            if (grid[pos.first][pos.second] == 'S') {
+                if (smallest == 0 || ship.size < smallest) smallest = ship.size;
+                break;
+            }
+        }
+    }
+    return smallest;
+}
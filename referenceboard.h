@@ -0,0 +1,37 @@
+#ifndef REFERENCEBOARD_H
+#define REFERENCEBOARD_H
+
+#include <QVector>
+#include <QPair>
+#include "board.h"
+
+// The original grid-of-chars Board, kept unoptimised as the oracle the fuzzer
+// compares Board against. Do not speed this up.
+struct ReferenceShip {
+    int row;
+    int col;
+    bool isVertical;
+    int size;
+    QVector<QPair<int, int>> positions;
+};
+
+class ReferenceBoard {
+public:
+    ReferenceBoard(int rows, int cols);
+
+    bool isValidPosition(int row, int col, bool isVertical, int shipLength);
+    void placeShip(int row, int col, bool isVertical, int shipLength, char symbol = 'S');
+    bool attack(int row, int col);
+    bool hasShipsRemaining();
+    char getCell(int row, int col) const;
+    bool isSunkAt(int row, int col) const;
+    int smallestShipRemaining() const;
+
+private:
+    QVector<QVector<char>> grid;
+    QVector<ReferenceShip> ships;
+    int gridRows;
+    int gridCols;
+};
+
+#endif // REFERENCEBOARD_H
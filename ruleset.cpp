@@ -0,0 +1,146 @@
+#include "ruleset.h"
+#include <QStringList>
+#include <algorithm>
+
+// Default is the original 7x7 three-ship game
+RuleSet::RuleSet() : rows(7), cols(7), shipLengths({5, 4, 3}), salvo(0) {
+}
+
+// Standard 10x10 game: carrier, battleship, cruiser, submarine, destroyer
+RuleSet RuleSet::classic() {
+    RuleSet rules;
+    rules.rows = 10;
+    rules.cols = 10;
+    rules.shipLengths = {5, 4, 3, 3, 2};
+    return rules;
+}
+
+// The original 7x7 board with 1-5 ships of length 3-5
+RuleSet RuleSet::compact(int numShips) {
+    static const int lengths[] = {5, 4, 3, 4, 3};
+    RuleSet rules;
+    rules.shipLengths.clear();
+    for (int i = 0; i < qBound(1, numShips, 5); ++i) rules.shipLengths.append(lengths[i]);
+    std::sort(rules.shipLengths.begin(), rules.shipLengths.end(), std::greater<int>());
+    return rules;
+}
+
+// Accepts "classic", "compact:<ships>" or "<rows>x<cols>:<len>,<len>,...",
+// optionally followed by "/salvo" (one shot per ship afloat) or "/salvo:<n>".
+RuleSet RuleSet::parse(const QString &spec, bool *ok) {
+    RuleSet rules;
+    bool valid = false;
+    QString text = spec.trimmed().toLower().section('/', 0, 0);
+    QString variant = spec.trimmed().toLower().section('/', 1);
+
+    if (text == "classic") {
+        rules = classic();
+        valid = true;
+    } else if (text.startsWith("compact")) {
+        int numShips = text.section(':', 1).toInt(&valid);
+        if (text == "compact") {
+            numShips = 3;
+            valid = true;
+        }
+        rules = compact(numShips);
+    } else {
+        QStringList dims = text.section(':', 0, 0).split('x');
+        QStringList lengths = text.section(':', 1).split(',');
+        bool rowsOk = false, colsOk = false;
+        if (dims.size() == 2) {
+            rules.rows = dims[0].toInt(&rowsOk);
+            rules.cols = dims[1].toInt(&colsOk);
+        }
+        valid = rowsOk && colsOk;
+        rules.shipLengths.clear();
+        for (const QString &length : lengths) {
+            bool lengthOk = false;
+            rules.shipLengths.append(length.toInt(&lengthOk));
+            valid = valid && lengthOk;
+        }
+        std::sort(rules.shipLengths.begin(), rules.shipLengths.end(), std::greater<int>());
+    }
+
+    if (variant == "salvo") {
+        rules.salvo = SALVO_PER_SHIP;
+    } else if (variant.startsWith("salvo:")) {
+        bool shotsOk = false;
+        rules.salvo = variant.section(':', 1).toInt(&shotsOk);
+        valid = valid && shotsOk && rules.salvo > 0;
+    } else if (!variant.isEmpty()) {
+        valid = false;
+    }
+
+    valid = valid && rules.isValid();
+    if (ok) *ok = valid;
+    return valid ? rules : RuleSet();
+}
+
+int RuleSet::cells() const {
+    return rows * cols;
+}
+
+int RuleSet::shipCount() const {
+    return shipLengths.size();
+}
+
+int RuleSet::smallestShip() const {
+    return shipLengths.isEmpty() ? 0 : *std::min_element(shipLengths.begin(), shipLengths.end());
+}
+
+int RuleSet::largestShip() const {
+    return shipLengths.isEmpty() ? 0 : *std::max_element(shipLengths.begin(), shipLengths.end());
+}
+
+int RuleSet::fleetCells() const {
+    int total = 0;
+    for (int length : shipLengths) total += length;
+    return total;
+}
+
+bool RuleSet::isSalvo() const {
+    return salvo != 0;
+}
+
+// Shots the side with `shipsAfloat` ships left may fire this turn.
+int RuleSet::shotsPerTurn(int shipsAfloat) const {
+    if (salvo == SALVO_PER_SHIP) return qMax(1, shipsAfloat);
+    return salvo > 0 ? salvo : 1;
+}
+
+bool RuleSet::isValid() const {
+    if (rows < 2 || cols < 2 || rows > MAX_GRID_SIZE || cols > MAX_GRID_SIZE) return false;
+    if (shipLengths.isEmpty() || shipLengths.size() > MAX_SHIPS) return false;
+    if (salvo < SALVO_PER_SHIP || salvo > cells()) return false;
+    for (int length : shipLengths) {
+        if (length < 1 || length > qMax(rows, cols)) return false;
+    }
+    // Leave room for placement to succeed without heroic packing
+    return fleetCells() * 2 <= cells();
+}
+
+QString RuleSet::toString() const {
+    QStringList lengths;
+    for (int length : shipLengths) lengths.append(QString::number(length));
+    QString spec = QString("%1x%2:%3").arg(rows).arg(cols).arg(lengths.join(","));
+    if (salvo == SALVO_PER_SHIP) spec += "/salvo";
+    else if (salvo > 0) spec += QString("/salvo:%1").arg(salvo);
+    return spec;
+}
+
+QString RuleSet::describe() const {
+    QStringList lengths;
+    for (int length : shipLengths) lengths.append(QString::number(length));
+    QString text = QString("%1x%2, ships %3").arg(rows).arg(cols).arg(lengths.join(" "));
+    if (salvo == SALVO_PER_SHIP) text += ", salvo";
+    else if (salvo > 0) text += QString(", salvo of %1").arg(salvo);
+    return text;
+}
+
+bool RuleSet::operator==(const RuleSet &other) const {
+    return rows == other.rows && cols == other.cols && shipLengths == other.shipLengths && salvo == other.salvo;
+}
+
+bool RuleSet::operator!=(const RuleSet &other) const {
+    return !(*this == other);
+}
@@ -0,0 +1,40 @@
+#ifndef RULESET_H
+#define RULESET_H
+
+#include <QVector>
+#include <QString>
+
+const int MAX_GRID_SIZE = 16;
+const int MAX_GRID_CELLS = MAX_GRID_SIZE * MAX_GRID_SIZE;
+const int MAX_SHIPS = 10;
+const int SALVO_PER_SHIP = -1;
+
+// Grid dimensions and the exact fleet both sides place.
+struct RuleSet {
+    int rows;
+    int cols;
+    QVector<int> shipLengths; // one entry per ship, longest first
+    int salvo; // 0: one shot per turn, SALVO_PER_SHIP: one per own ship afloat, n > 0: n per turn
+
+    RuleSet();
+
+    static RuleSet classic();
+    static RuleSet compact(int numShips);
+    static RuleSet parse(const QString &spec, bool *ok = nullptr);
+
+    int cells() const;
+    int shipCount() const;
+    int smallestShip() const;
+    int largestShip() const;
+    int fleetCells() const;
+    bool isSalvo() const;
+    int shotsPerTurn(int shipsAfloat) const;
+    bool isValid() const;
+    QString toString() const;
+    QString describe() const;
+
+    bool operator==(const RuleSet &other) const;
+    bool operator!=(const RuleSet &other) const;
+};
+
+#endif // RULESET_H
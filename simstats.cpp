@@ -0,0 +1,116 @@
+#include "simstats.h"
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <cstring>
+
+// cells is the board size in use; it only limits what gets reported.
+SimulationStats::SimulationStats(int cells) : boardCells(qBound(1, cells, int(CELLS))) {
+    totalGames = 0;
+    memset(shotsToWin, 0, sizeof(shotsToWin));
+    memset(firstHits, 0, sizeof(firstHits));
+    memset(winMatrix, 0, sizeof(winMatrix));
+}
+
+void SimulationStats::addMatch(BotPlayer::Difficulty first, BotPlayer::Difficulty second, const MatchResult &result) {
+    BotPlayer::Difficulty sides[2] = {first, second};
+    totalGames++;
+    for (int side = 0; side < 2; ++side) {
+        if (result.firstHit[side] >= 0) firstHits[sides[side]][result.firstHit[side]]++;
+    }
+    if (result.winner >= 0) {
+        BotPlayer::Difficulty winner = sides[result.winner];
+        shotsToWin[winner][result.shots[result.winner]]++;
+        winMatrix[winner][sides[1 - result.winner]]++;
+    }
+}
+
+void SimulationStats::merge(const SimulationStats &other) {
+    totalGames += other.totalGames;
+    for (int d = 0; d < DIFFICULTIES; ++d) {
+        for (int i = 0; i <= CELLS; ++i) shotsToWin[d][i] += other.shotsToWin[d][i];
+        for (int i = 0; i < CELLS; ++i) firstHits[d][i] += other.firstHits[d][i];
+        for (int o = 0; o < DIFFICULTIES; ++o) winMatrix[d][o] += other.winMatrix[d][o];
+    }
+}
+
+quint64 SimulationStats::games() const {
+    return totalGames;
+}
+
+quint64 SimulationStats::wins(BotPlayer::Difficulty winner, BotPlayer::Difficulty loser) const {
+    return winMatrix[winner][loser];
+}
+
+// Smallest shot count s with at least q (0..1) of the wins taking s shots or fewer.
+int SimulationStats::shotsToWinQuantile(BotPlayer::Difficulty difficulty, double q) const {
+    quint64 total = 0;
+    for (int i = 0; i <= boardCells; ++i) total += shotsToWin[difficulty][i];
+    if (total == 0) return 0;
+
+    quint64 rank = qMax<quint64>(1, quint64(q * total + 0.5));
+    quint64 seen = 0;
+    for (int i = 0; i <= boardCells; ++i) {
+        seen += shotsToWin[difficulty][i];
+        if (seen >= rank) return i;
+    }
+    return boardCells;
+}
+
+double SimulationStats::meanShotsToWin(BotPlayer::Difficulty difficulty) const {
+    quint64 total = 0, sum = 0;
+    for (int i = 0; i <= boardCells; ++i) {
+        total += shotsToWin[difficulty][i];
+        sum += shotsToWin[difficulty][i] * i;
+    }
+    return total ? double(sum) / total : 0.0;
+}
+
+QString SimulationStats::toText() const {
+    QString text = QString("%1 games\n\nshots to win   mean    p10    p50    p90\n").arg(totalGames);
+    for (int d = 0; d < DIFFICULTIES; ++d) {
+        BotPlayer::Difficulty difficulty = BotPlayer::Difficulty(d);
+        text += QString("%1 %2 %3 %4 %5\n")
+                    .arg(QString::fromLatin1(BotPlayer::difficultyName(difficulty)), -12)
+                    .arg(meanShotsToWin(difficulty), 6, 'f', 2)
+                    .arg(shotsToWinQuantile(difficulty, 0.1), 6)
+                    .arg(shotsToWinQuantile(difficulty, 0.5), 6)
+                    .arg(shotsToWinQuantile(difficulty, 0.9), 6);
+    }
+
+    text += "\nwin matrix (row beat column)\n" + QString(12, ' ');
+    for (int o = 0; o < DIFFICULTIES; ++o) {
+        text += QString("%1").arg(QString::fromLatin1(BotPlayer::difficultyName(BotPlayer::Difficulty(o))), 10);
+    }
+    text += "\n";
+    for (int d = 0; d < DIFFICULTIES; ++d) {
+        text += QString("%1").arg(QString::fromLatin1(BotPlayer::difficultyName(BotPlayer::Difficulty(d))), -12);
+        for (int o = 0; o < DIFFICULTIES; ++o) text += QString("%1").arg(winMatrix[d][o], 10);
+        text += "\n";
+    }
+    return text;
+}
+
+QString SimulationStats::toJson() const {
+    QJsonObject root;
+    root["games"] = double(totalGames);
+
+    QJsonObject perDifficulty;
+    for (int d = 0; d < DIFFICULTIES; ++d) {
+        BotPlayer::Difficulty difficulty = BotPlayer::Difficulty(d);
+        QJsonObject entry;
+        QJsonArray histogram, firstHitCells, winsAgainst;
+        for (int i = 0; i <= boardCells; ++i) histogram.append(double(shotsToWin[d][i]));
+        for (int i = 0; i < boardCells; ++i) firstHitCells.append(double(firstHits[d][i]));
+        for (int o = 0; o < DIFFICULTIES; ++o) winsAgainst.append(double(winMatrix[d][o]));
+        entry["shots_to_win_histogram"] = histogram;
+        entry["shots_to_win_mean"] = meanShotsToWin(difficulty);
+        entry["shots_to_win_p50"] = shotsToWinQuantile(difficulty, 0.5);
+        entry["shots_to_win_p90"] = shotsToWinQuantile(difficulty, 0.9);
+        entry["first_hit_frequency"] = firstHitCells;
+        entry["wins_against"] = winsAgainst;
+        perDifficulty[QString::fromLatin1(BotPlayer::difficultyName(difficulty))] = entry;
+    }
+    root["difficulties"] = perDifficulty;
+    return QString::fromUtf8(QJsonDocument(root).toJson());
+}
@@ -0,0 +1,36 @@
+#ifndef SIMSTATS_H
+#define SIMSTATS_H
+
+#include <QString>
+#include "botplayer.h"
+#include "simulation.h"
+
+// Aggregate statistics over any number of simulated matches in constant memory.
+// Shots-to-win is bounded by the cell count, so a fixed histogram gives exact
+// quantiles. Each thread keeps its own instance; merge() adds them up.
+class SimulationStats {
+public:
+    explicit SimulationStats(int cells = MAX_GRID_CELLS);
+
+    void addMatch(BotPlayer::Difficulty first, BotPlayer::Difficulty second, const MatchResult &result);
+    void merge(const SimulationStats &other);
+
+    quint64 games() const;
+    quint64 wins(BotPlayer::Difficulty winner, BotPlayer::Difficulty loser) const;
+    int shotsToWinQuantile(BotPlayer::Difficulty difficulty, double q) const;
+    double meanShotsToWin(BotPlayer::Difficulty difficulty) const;
+
+    QString toText() const;
+    QString toJson() const;
+
+private:
+    enum { DIFFICULTIES = BotPlayer::DIFFICULTY_COUNT, CELLS = MAX_GRID_CELLS };
+
+    int boardCells;
+    quint64 totalGames;
+    quint64 shotsToWin[DIFFICULTIES][CELLS + 1];
+    quint64 firstHits[DIFFICULTIES][CELLS];
+    quint64 winMatrix[DIFFICULTIES][DIFFICULTIES];
+};
+
+#endif // SIMSTATS_H
@@ -0,0 +1,44 @@
+#include "simulation.h"
+
+MatchResult playMatch(BotPlayer &first, BotPlayer &second, const RuleSet &rules) {
+    BotPlayer *players[2] = {&first, &second};
+    Board boards[2] = {Board(rules), Board(rules)};
+    MatchResult result = {-1, {0, 0}, {-1, -1}};
+
+    for (int side = 0; side < 2; ++side) {
+        BotPlayer::placeShips(boards[side], rules);
+        players[side]->reset();
+    }
+
+    // Each side fires at the other side's board until one fleet is gone
+    for (int turn = 0; turn < 2 * rules.cells(); ++turn) {
+        int side = turn % 2;
+        Board &target = boards[1 - side];
+        if (rules.isSalvo()) {
+            SalvoResult salvo = players[side]->attackSalvo(target, rules.shotsPerTurn(boards[side].shipsAfloat()));
+            result.shots[side] += salvo.shots.count();
+            // Within a salvo the lowest numbered hit counts as the first
+            if (!salvo.hits.isEmpty() && result.firstHit[side] < 0) {
+                result.firstHit[side] = salvo.hits.select(0);
+            }
+            if (!target.hasShipsRemaining()) {
+                result.winner = side;
+                break;
+            }
+            continue;
+        }
+
+        BotShot shot = players[side]->attack(target);
+        if (shot.row < 0) continue;
+
+        result.shots[side]++;
+        if (shot.hit && result.firstHit[side] < 0) {
+            result.firstHit[side] = shot.row * rules.cols + shot.col;
+        }
+        if (!target.hasShipsRemaining()) {
+            result.winner = side;
+            break;
+        }
+    }
+    return result;
+}
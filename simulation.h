@@ -0,0 +1,16 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "board.h"
+#include "botplayer.h"
+
+struct MatchResult {
+    int winner;      // 0 or 1, -1 if neither side finished
+    int shots[2];    // shots fired by each side
+    int firstHit[2]; // cell (row * cols + col) of each side's first hit, -1 if none
+};
+
+// Bot-vs-bot game on fresh random fleets; players[0] fires first.
+MatchResult playMatch(BotPlayer &first, BotPlayer &second, const RuleSet &rules);
+
+#endif // SIMULATION_H
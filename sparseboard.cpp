@@ -0,0 +1,135 @@
+#include "sparseboard.h"
+#include "latencyprobe.h"
+#include "tracing.h"
+
+SparseBoard::SparseBoard(int rows, int cols) : afloat(0), shots(0), gridRows(rows), gridCols(cols) {
+}
+
+void SparseBoard::resetBoard() {
+    TRACE_SPAN("board", "resetBoard");
+    tiles.clear();
+    cellShip.clear();
+    ships.clear();
+    afloatByLength.clear();
+    afloat = 0;
+    shots = 0;
+}
+
+bool SparseBoard::isValidPosition(int row, int col, bool isVertical, int shipLength) {
+    LATENCY_PROBE("sparse.isValidPosition");
+    if (isVertical) {
+        if (row + shipLength > gridRows) return false;
+    } else {
+        if (col + shipLength > gridCols) return false;
+    }
+    for (int i = 0; i < shipLength; i++) {
+        int r = isVertical ? row + i : row;
+        int c = isVertical ? col : col + i;
+        auto tile = tiles.constFind(tileKey(r, c));
+        if (tile != tiles.constEnd() && ((tile->ships | tile->shots) & cellBit(r, c))) return false;
+    }
+    return true;
+}
+
+void SparseBoard::placeShip(int row, int col, bool isVertical, int shipLength, char symbol) {
+    Q_UNUSED(symbol);
+    LATENCY_PROBE("sparse.placeShip");
+    TRACE_SPAN("board", "placeShip");
+    int id = ships.size();
+    ships.append({row, col, shipLength, isVertical, 0});
+    if (afloatByLength.size() <= shipLength) afloatByLength.resize(shipLength + 1);
+    afloatByLength[shipLength]++;
+    afloat++;
+    for (int i = 0; i < shipLength; i++) {
+        int r = isVertical ? row + i : row;
+        int c = isVertical ? col : col + i;
+        Tile &tile = tiles[tileKey(r, c)]; // value-initialised to empty on first touch
+        tile.ships |= cellBit(r, c);
+        cellShip.insert(cellKey(r, c), id);
+    }
+}
+
+bool SparseBoard::attack(int row, int col) {
+    LATENCY_PROBE("sparse.attack");
+    TRACE_SPAN("board", "attack");
+    Tile &tile = tiles[tileKey(row, col)];
+    quint64 bit = cellBit(row, col);
+    if (tile.shots & bit) return false;
+    tile.shots |= bit;
+    shots++;
+    if (!(tile.ships & bit)) return false;
+
+    Ship &ship = ships[cellShip.value(cellKey(row, col))];
+    if (++ship.hits == ship.length) {
+        afloat--;
+        afloatByLength[ship.length]--;
+    }
+    return true;
+}
+
+bool SparseBoard::hasShipsRemaining() const {
+    return afloat > 0;
+}
+
+char SparseBoard::getCell(int row, int col) const {
+    auto tile = tiles.constFind(tileKey(row, col));
+    if (tile == tiles.constEnd()) return '~';
+    quint64 bit = cellBit(row, col);
+    if (tile->ships & bit) return (tile->shots & bit) ? 'X' : 'S';
+    return (tile->shots & bit) ? 'O' : '~';
+}
+
+// Length of the shortest ship that still has an unhit cell, 0 if all are sunk.
+int SparseBoard::smallestShipRemaining() const {
+    for (int length = 1; length < afloatByLength.size(); ++length) {
+        if (afloatByLength[length] > 0) return length;
+    }
+    return 0;
+}
+
+// Ship id covering the cell, or -1 for open water.
+int SparseBoard::shipAt(int row, int col) const {
+    return cellShip.value(cellKey(row, col), -1);
+}
+
+bool SparseBoard::isShipSunk(int shipId) const {
+    return ships[shipId].hits == ships[shipId].length;
+}
+
+bool SparseBoard::isSunkAt(int row, int col) const {
+    int id = shipAt(row, col);
+    return id >= 0 && isShipSunk(id);
+}
+
+int SparseBoard::shipsAfloat() const {
+    return afloat;
+}
+
+int SparseBoard::shipCount() const {
+    return ships.size();
+}
+
+int SparseBoard::rows() const {
+    return gridRows;
+}
+
+int SparseBoard::cols() const {
+    return gridCols;
+}
+
+qint64 SparseBoard::cells() const {
+    return qint64(gridRows) * gridCols;
+}
+
+qint64 SparseBoard::untriedCount() const {
+    return cells() - shots;
+}
+
+bool SparseBoard::isInside(int row, int col) const {
+    return row >= 0 && row < gridRows && col >= 0 && col < gridCols;
+}
+
+// Tiles allocated so far; memory is roughly this times the size of one tile.
+int SparseBoard::tileCount() const {
+    return tiles.size();
+}
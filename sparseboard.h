@@ -0,0 +1,62 @@
+#ifndef SPARSEBOARD_H
+#define SPARSEBOARD_H
+
+#include <QHash>
+#include <QVector>
+
+// Board for very large grids (the "ocean" variant). Only 8x8 tiles that hold
+// a ship cell or a shot are stored, and ship cells are indexed by cell, so
+// memory grows with ships and shots rather than area and every call below is
+// O(1) (O(length) for placement). Same interface as Board, minus the dense
+// untriedMask(), which does not make sense at this size.
+class SparseBoard {
+public:
+    SparseBoard(int rows, int cols);
+
+    void resetBoard();
+    bool isValidPosition(int row, int col, bool isVertical, int shipLength);
+    void placeShip(int row, int col, bool isVertical, int shipLength, char symbol = 'S');
+    bool attack(int row, int col);
+    bool hasShipsRemaining() const;
+    char getCell(int row, int col) const;
+    int smallestShipRemaining() const;
+    int shipAt(int row, int col) const;
+    bool isShipSunk(int shipId) const;
+    bool isSunkAt(int row, int col) const;
+    int shipsAfloat() const;
+    int shipCount() const;
+    int rows() const;
+    int cols() const;
+    qint64 cells() const;
+    qint64 untriedCount() const;
+    bool isInside(int row, int col) const;
+    int tileCount() const;
+
+private:
+    struct Tile {
+        quint64 ships; // bit (row % 8) * 8 + col % 8 set for ship cells
+        quint64 shots; // same layout, set once the cell has been attacked
+    };
+    struct Ship {
+        int row;
+        int col;
+        int length;
+        bool vertical;
+        int hits;
+    };
+
+    static quint64 tileKey(int row, int col) { return (quint64(quint32(row) >> 3) << 32) | (quint32(col) >> 3); }
+    static quint64 cellKey(int row, int col) { return (quint64(quint32(row)) << 32) | quint32(col); }
+    static quint64 cellBit(int row, int col) { return quint64(1) << ((row & 7) * 8 + (col & 7)); }
+
+    QHash<quint64, Tile> tiles;
+    QHash<quint64, int> cellShip;
+    QVector<Ship> ships;
+    QVector<int> afloatByLength; // ships still afloat, indexed by length
+    int afloat;
+    qint64 shots;
+    int gridRows;
+    int gridCols;
+};
+
+#endif // SPARSEBOARD_H
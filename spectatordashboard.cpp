@@ -0,0 +1,224 @@
+#include "spectatordashboard.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QtMath>
+#include "botplayer.h"
+
+namespace {
+
+const int STATS_HEIGHT = 140;
+const int MARGIN = 4;
+
+}
+
+SpectatorDashboard::SpectatorDashboard(const RuleSet &rules, int games, int threads, QWidget *parent)
+    : QWidget(parent), rules(rules), stopping(false), rateMark(0), finishedAtMark(0), finished(0),
+    gamesPerSecond(0), shotHistogram(rules.cells() + 1, 0)
+{
+    games = qMax(1, games);
+    threads = qBound(1, threads, games);
+    for (int game = 0; game < games; ++game) {
+        GameEventStream *stream = new GameEventStream;
+        stream->subscribe();
+        streams.append(stream);
+    }
+    thumbnails.resize(games);
+
+    setWindowTitle(QString("Spectator: %1 games on %2 threads").arg(games).arg(threads));
+    resize(1000, 800);
+
+    // Streams are complete before the first worker publishes
+    sinceStart.start();
+    for (int worker = 0; worker < threads; ++worker) {
+        workers.emplace_back(&SpectatorDashboard::runWorker, this, worker, threads);
+    }
+    connect(&frameTimer, &QTimer::timeout, this, &SpectatorDashboard::drainEvents);
+    frameTimer.start(1000 / MAX_FPS);
+}
+
+SpectatorDashboard::~SpectatorDashboard() {
+    frameTimer.stop();
+    stopping.store(true, std::memory_order_relaxed);
+    for (std::thread &worker : workers) worker.join();
+    qDeleteAll(streams);
+}
+
+// Plays games first, first + step, ... a shot at a time, round robin, so
+// every game on the worker is in progress at once.
+void SpectatorDashboard::runWorker(int first, int step) {
+    struct LiveGame {
+        int index;
+        Board boards[2]; // boards[side] holds that side's fleet
+        BotPlayer bots[2];
+        int turn;
+    };
+    // Only read here; the view owns the vector and never changes it while workers run
+    const QVector<GameEventStream *> &gameStreams = streams;
+    QVector<LiveGame> games;
+    for (int game = first; game < gameStreams.size(); game += step) {
+        LiveGame live;
+        live.index = game;
+        live.bots[0] = BotPlayer(BotPlayer::Difficulty(game % BotPlayer::DIFFICULTY_COUNT));
+        live.bots[1] = BotPlayer(BotPlayer::Difficulty(game / BotPlayer::DIFFICULTY_COUNT % BotPlayer::DIFFICULTY_COUNT));
+        live.turn = -1; // deal on the first pass
+        games.append(live);
+    }
+
+    while (!stopping.load(std::memory_order_relaxed)) {
+        for (LiveGame &live : games) {
+            GameEventStream &stream = *gameStreams.at(live.index);
+            if (live.turn < 0) {
+                for (int side = 0; side < 2; ++side) {
+                    live.boards[side] = Board(rules);
+                    BotPlayer::placeShips(live.boards[side], rules);
+                    live.bots[side].reset();
+                }
+                live.turn = 0;
+                stream.newGame();
+            }
+
+            int side = live.turn % 2;
+            Board &target = live.boards[1 - side];
+            BotShot shot = live.bots[side].attack(target);
+            if (shot.row >= 0) stream.shot(side, target, shot.row, shot.col, shot.hit);
+            if (shot.row < 0 || !target.hasShipsRemaining()) {
+                stream.gameOver(side);
+                live.turn = -1;
+            } else {
+                live.turn++;
+            }
+        }
+    }
+}
+
+// Frame tick: folds every queued event into the thumbnails and stats, then
+// asks for a single repaint covering the thumbnails that changed.
+void SpectatorDashboard::drainEvents() {
+    QRegion dirty;
+    for (int game = 0; game < streams.size(); ++game) {
+        GameEvent event;
+        bool changed = false;
+        while (streams.at(game)->poll(0, event)) {
+            apply(thumbnails[game], event);
+            changed = true;
+        }
+        if (changed) dirty += thumbnailRect(game);
+    }
+
+    qint64 now = sinceStart.elapsed();
+    if (now - rateMark >= 1000) {
+        gamesPerSecond = (finished - finishedAtMark) * 1000.0 / (now - rateMark);
+        finishedAtMark = finished;
+        rateMark = now;
+        dirty += statsRect();
+    }
+    if (!dirty.isEmpty()) update(dirty);
+}
+
+void SpectatorDashboard::apply(Thumbnail &thumbnail, const GameEvent &event) {
+    // A new game number clears the board the last game left on screen
+    if (event.game != thumbnail.game || thumbnail.cells[0].isEmpty()) {
+        thumbnail.game = event.game;
+        for (int side = 0; side < 2; ++side) {
+            thumbnail.cells[side] = QVector<quint8>(rules.cells(), Untried);
+            thumbnail.shots[side] = 0;
+        }
+    }
+
+    int side = event.player & 1;
+    int cell = event.row * rules.cols + event.col;
+    switch (event.type) {
+    case GameEvent::ShotFired:
+        thumbnail.shots[side]++;
+        break;
+    case GameEvent::Hit:
+        thumbnail.cells[side][cell] = Hit;
+        break;
+    case GameEvent::Miss:
+        thumbnail.cells[side][cell] = Missed;
+        break;
+    case GameEvent::Sunk:
+        thumbnail.cells[side][cell] = Sank;
+        break;
+    case GameEvent::GameOver:
+        finished++;
+        shotHistogram[qMin(thumbnail.shots[side], rules.cells())]++;
+        break;
+    default:
+        break;
+    }
+}
+
+int SpectatorDashboard::columns() const {
+    return qMax(1, qCeil(qSqrt(double(streams.size()))));
+}
+
+QRect SpectatorDashboard::thumbnailRect(int game) const {
+    int across = columns();
+    int down = (streams.size() + across - 1) / across;
+    int tileWidth = width() / across;
+    int tileHeight = qMax(1, height() - STATS_HEIGHT) / down;
+    return QRect(game % across * tileWidth, game / across * tileHeight, tileWidth, tileHeight);
+}
+
+QRect SpectatorDashboard::statsRect() const {
+    return QRect(0, qMax(0, height() - STATS_HEIGHT), width(), STATS_HEIGHT);
+}
+
+void SpectatorDashboard::paintEvent(QPaintEvent *event) {
+    QPainter painter(this);
+    for (int game = 0; game < streams.size(); ++game) {
+        if (event->region().intersects(thumbnailRect(game))) paintThumbnail(painter, game);
+    }
+    if (event->region().intersects(statsRect())) paintStats(painter);
+}
+
+// Both target boards side by side: side 0's shots on the left
+void SpectatorDashboard::paintThumbnail(QPainter &painter, int game) {
+    static const QColor colors[] = {QColor(20, 40, 90), QColor(150, 160, 175), QColor(240, 140, 30), QColor(200, 30, 30)};
+    QRect rect = thumbnailRect(game);
+    painter.fillRect(rect, palette().window());
+
+    const Thumbnail &thumbnail = thumbnails[game];
+    int cell = qMax(1, qMin((rect.width() - 3 * MARGIN) / (2 * rules.cols), (rect.height() - 2 * MARGIN) / rules.rows));
+    for (int side = 0; side < 2; ++side) {
+        int left = rect.left() + MARGIN + side * (rules.cols * cell + MARGIN);
+        int top = rect.top() + MARGIN;
+        for (int at = 0; at < rules.cells(); ++at) {
+            quint8 state = thumbnail.cells[side].isEmpty() ? quint8(Untried) : thumbnail.cells[side][at];
+            painter.fillRect(left + at % rules.cols * cell, top + at / rules.cols * cell, cell, cell, colors[state]);
+        }
+    }
+}
+
+void SpectatorDashboard::paintStats(QPainter &painter) {
+    QRect rect = statsRect();
+    painter.fillRect(rect, palette().base());
+
+    quint64 dropped = 0;
+    for (const GameEventStream *stream : streams) dropped += stream->dropped(0);
+    quint64 largest = 1;
+    double shots = 0;
+    for (int count = 0; count < shotHistogram.size(); ++count) {
+        largest = qMax(largest, shotHistogram[count]);
+        shots += double(count) * shotHistogram[count];
+    }
+    painter.setPen(palette().text().color());
+    painter.drawText(rect.adjusted(MARGIN, MARGIN, -MARGIN, 0), Qt::AlignLeft | Qt::AlignTop,
+                     QString("%1 games/s    %2 finished    %3 shots to win on average    %4 events dropped")
+                         .arg(gamesPerSecond, 0, 'f', 0)
+                         .arg(finished)
+                         .arg(finished ? shots / finished : 0.0, 0, 'f', 1)
+                         .arg(dropped));
+
+    // Shots-to-win histogram, one bar per shot count
+    QRect bars = rect.adjusted(MARGIN, 24, -MARGIN, -MARGIN);
+    double barWidth = double(bars.width()) / shotHistogram.size();
+    for (int count = 0; count < shotHistogram.size(); ++count) {
+        int barHeight = int(bars.height() * double(shotHistogram[count]) / largest);
+        if (barHeight == 0) continue;
+        painter.fillRect(QRectF(bars.left() + count * barWidth, bars.bottom() - barHeight, qMax(1.0, barWidth - 1),
+                                barHeight),
+                         QColor(70, 130, 180));
+    }
+}
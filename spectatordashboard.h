@@ -0,0 +1,66 @@
+#ifndef SPECTATORDASHBOARD_H
+#define SPECTATORDASHBOARD_H
+
+#include <QWidget>
+#include <QPainter>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QVector>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "gameevents.h"
+
+// Live view of many bot-vs-bot games played on worker threads: a thumbnail of
+// both boards per game, games per second, and a histogram of the shots the
+// winners needed. Each game publishes into its own GameEventStream, so the
+// workers never wait on the view (a queue that fills up drops events, which
+// are counted). The view drains the queues at most MAX_FPS times a second and
+// asks for one repaint of just the thumbnails that changed.
+class SpectatorDashboard : public QWidget {
+    Q_OBJECT
+
+public:
+    static const int MAX_FPS = 30;
+
+    // Game i pits difficulty i % 4 against difficulty (i / 4) % 4
+    SpectatorDashboard(const RuleSet &rules, int games, int threads, QWidget *parent = nullptr);
+    ~SpectatorDashboard() override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    // What the view knows of one game, built from its events
+    struct Thumbnail {
+        quint32 game = 0;
+        QVector<quint8> cells[2]; // side's target board: Untried, Missed, Hit or Sank
+        int shots[2] = {0, 0};
+    };
+    enum CellState : quint8 { Untried, Missed, Hit, Sank };
+
+    RuleSet rules;
+    QVector<GameEventStream *> streams; // one per game, subscriber 0 is the view
+    QVector<Thumbnail> thumbnails;
+    std::vector<std::thread> workers;
+    std::atomic<bool> stopping;
+
+    QTimer frameTimer;
+    QElapsedTimer sinceStart;
+    qint64 rateMark;       // sinceStart at the last games/s sample
+    quint64 finishedAtMark;
+    quint64 finished;
+    double gamesPerSecond;
+    QVector<quint64> shotHistogram; // finished games by the winner's shots
+
+    void runWorker(int first, int step);
+    void drainEvents();
+    void apply(Thumbnail &thumbnail, const GameEvent &event);
+    int columns() const;
+    QRect thumbnailRect(int game) const;
+    QRect statsRect() const;
+    void paintThumbnail(QPainter &painter, int game);
+    void paintStats(QPainter &painter);
+};
+
+#endif // SPECTATORDASHBOARD_H
@@ -0,0 +1,50 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <QtGlobal>
+#include <atomic>
+
+// Lock-free ring buffer for one producer thread and one consumer thread.
+// Each side owns one index and only reads the other's, so push and pop are a
+// copy and an acquire/release pair; the indices sit on separate cache lines
+// so the two sides do not bounce one line between cores. T must be trivially
+// copyable.
+template <class T, int Capacity>
+class SpscQueue {
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    SpscQueue() : head(0), tail(0) {}
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side. False, and nothing queued, when the queue is full.
+    bool push(const T &item) {
+        quint32 at = tail.load(std::memory_order_relaxed);
+        if (at - head.load(std::memory_order_acquire) == quint32(Capacity)) return false;
+        items[at & (Capacity - 1)] = item;
+        tail.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. False when the queue is empty.
+    bool pop(T &item) {
+        quint32 at = head.load(std::memory_order_relaxed);
+        if (at == tail.load(std::memory_order_acquire)) return false;
+        item = items[at & (Capacity - 1)];
+        head.store(at + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Exact only on the consumer side, and only as of the call
+    bool isEmpty() const {
+        return head.load(std::memory_order_relaxed) == tail.load(std::memory_order_acquire);
+    }
+
+private:
+    alignas(64) std::atomic<quint32> head; // next slot to pop, written by the consumer
+    alignas(64) std::atomic<quint32> tail; // next slot to push, written by the producer
+    alignas(64) T items[Capacity];
+};
+
+#endif // SPSCQUEUE_H
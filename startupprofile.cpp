@@ -0,0 +1,50 @@
+#include "startupprofile.h"
+#include <QElapsedTimer>
+#include <QVector>
+
+namespace {
+
+struct Phase {
+    const char *name;
+    qint64 nanos;
+    bool userWait;
+};
+
+bool enabled = false;
+QElapsedTimer sinceStart;
+qint64 lastMark = 0;
+QVector<Phase> phases;
+
+}
+
+void StartupProfile::start() {
+    enabled = true;
+    sinceStart.start();
+    lastMark = 0;
+    phases.clear();
+}
+
+bool StartupProfile::isEnabled() {
+    return enabled;
+}
+
+void StartupProfile::mark(const char *phase, bool userWait) {
+    if (!enabled) return;
+    qint64 now = sinceStart.nsecsElapsed();
+    phases.append(Phase{phase, now - lastMark, userWait});
+    lastMark = now;
+}
+
+QString StartupProfile::report() {
+    QString text = "Startup profile:\n";
+    qint64 total = 0;
+    for (const Phase &phase : phases) {
+        text += QString("  %1 %2 ms%3\n")
+                    .arg(QString(phase.name).leftJustified(20))
+                    .arg(phase.nanos / 1e6, 8, 'f', 2)
+                    .arg(phase.userWait ? " (waiting for the user, not counted)" : "");
+        if (!phase.userWait) total += phase.nanos;
+    }
+    text += QString("  %1 %2 ms\n").arg(QString("time to first paint").leftJustified(20)).arg(total / 1e6, 8, 'f', 2);
+    return text;
+}
@@ -0,0 +1,18 @@
+#ifndef STARTUPPROFILE_H
+#define STARTUPPROFILE_H
+
+#include <QString>
+
+// Wall-clock phases from the start of main() to the main window's first
+// paint, for --profile-startup. Each mark ends the phase that began at the
+// previous one. Phases spent waiting on the user (the setup dialog) are
+// listed but left out of the time to first paint.
+class StartupProfile {
+public:
+    static void start();
+    static bool isEnabled();
+    static void mark(const char *phase, bool userWait = false);
+    static QString report();
+};
+
+#endif // STARTUPPROFILE_H
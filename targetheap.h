@@ -0,0 +1,93 @@
+#ifndef TARGETHEAP_H
+#define TARGETHEAP_H
+
+#include "gridgeometry.h"
+
+// Indexed binary max-heap of padded cell ids keyed by score. The slot table
+// maps a cell to its heap position, so a cell's score can be raised or
+// lowered in place (update) or the cell dropped (remove) in O(log n).
+class TargetHeap {
+public:
+    TargetHeap() : count(0) {
+        for (int cell = 0; cell < PADDED_CELLS; ++cell) slot[cell] = -1;
+    }
+
+    void clear() {
+        for (int i = 0; i < count; ++i) slot[heap[i]] = -1;
+        count = 0;
+    }
+
+    bool isEmpty() const { return count == 0; }
+    int size() const { return count; }
+    bool contains(int cell) const { return slot[cell] >= 0; }
+    int top() const { return heap[0]; }
+    int at(int index) const { return heap[index]; } // heap order, for walking every queued cell
+    int score(int cell) const { return scores[cell]; }
+
+    // Inserts the cell, or moves it to its new score if already queued.
+    void update(int cell, int newScore) {
+        if (slot[cell] < 0) {
+            scores[cell] = newScore;
+            place(count, cell);
+            siftUp(count++);
+            return;
+        }
+        int oldScore = scores[cell];
+        scores[cell] = newScore;
+        if (newScore > oldScore) siftUp(slot[cell]);
+        else siftDown(slot[cell]);
+    }
+
+    int pop() {
+        int cell = heap[0];
+        remove(cell);
+        return cell;
+    }
+
+    void remove(int cell) {
+        int at = slot[cell];
+        slot[cell] = -1;
+        if (--count == at) return;
+        int moved = heap[count];
+        place(at, moved);
+        siftUp(at);
+        if (slot[moved] == at) siftDown(at);
+    }
+
+private:
+    quint16 heap[PADDED_CELLS];
+    int scores[PADDED_CELLS];
+    qint16 slot[PADDED_CELLS];
+    int count;
+
+    void place(int at, int cell) {
+        heap[at] = cell;
+        slot[cell] = at;
+    }
+
+    void siftUp(int at) {
+        int cell = heap[at];
+        while (at > 0) {
+            int parent = (at - 1) / 2;
+            if (scores[heap[parent]] >= scores[cell]) break;
+            place(at, heap[parent]);
+            at = parent;
+        }
+        place(at, cell);
+    }
+
+    void siftDown(int at) {
+        int cell = heap[at];
+        for (;;) {
+            int child = 2 * at + 1;
+            if (child >= count) break;
+            if (child + 1 < count && scores[heap[child + 1]] > scores[heap[child]]) child++;
+            if (scores[heap[child]] <= scores[cell]) break;
+            place(at, heap[child]);
+            at = child;
+        }
+        place(at, cell);
+    }
+};
+
+#endif // TARGETHEAP_H
@@ -0,0 +1,80 @@
+#ifndef TARGETQUEUE_H
+#define TARGETQUEUE_H
+
+#include "bitboard.h"
+#include "gridgeometry.h"
+
+// Fixed-capacity double-ended queue of padded cell ids for the bots' target
+// lists. A ring buffer big enough for every cell plus a membership bitset, so
+// push, pop and contains are O(1) and nothing allocates during a game. A cell
+// is queued at most once; pushing it again is a no-op.
+class TargetQueue {
+public:
+    enum { CAPACITY = 512 }; // power of two >= PADDED_CELLS
+
+    TargetQueue() : head(0), count(0) {}
+
+    void clear() {
+        head = 0;
+        count = 0;
+        queued = BitMask<PADDED_CELLS>();
+    }
+
+    bool isEmpty() const { return count == 0; }
+    int size() const { return count; }
+    bool contains(int cell) const { return queued.test(cell); }
+
+    int front() const { return cells[head]; }
+    int back() const { return cells[(head + count - 1) & (CAPACITY - 1)]; }
+    int at(int index) const { return cells[(head + index) & (CAPACITY - 1)]; }
+
+    bool pushFront(int cell) {
+        if (queued.test(cell)) return false;
+        queued.set(cell);
+        head = (head - 1) & (CAPACITY - 1);
+        cells[head] = cell;
+        count++;
+        return true;
+    }
+
+    bool pushBack(int cell) {
+        if (queued.test(cell)) return false;
+        queued.set(cell);
+        cells[(head + count) & (CAPACITY - 1)] = cell;
+        count++;
+        return true;
+    }
+
+    int popFront() {
+        int cell = cells[head];
+        head = (head + 1) & (CAPACITY - 1);
+        count--;
+        queued.reset(cell);
+        return cell;
+    }
+
+    int popBack() {
+        int cell = back();
+        count--;
+        queued.reset(cell);
+        return cell;
+    }
+
+    // Removes the entry at index by moving the back entry into its slot.
+    int takeAt(int index) {
+        int slot = (head + index) & (CAPACITY - 1);
+        int cell = cells[slot];
+        cells[slot] = back();
+        count--;
+        queued.reset(cell);
+        return cell;
+    }
+
+private:
+    quint16 cells[CAPACITY];
+    int head;
+    int count;
+    BitMask<PADDED_CELLS> queued;
+};
+
+#endif // TARGETQUEUE_H
@@ -0,0 +1,100 @@
+#include "tracing.h"
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QVector>
+
+namespace {
+
+struct TraceEvent {
+    const char *category;
+    const char *name;
+    qint64 begin;
+    qint64 end;
+};
+
+struct ThreadTrace {
+    int threadId;
+    quint64 written;
+    QVector<TraceEvent> events;
+};
+
+QMutex registryMutex;
+QVector<ThreadTrace *> threadTraces;
+int ringCapacity = 0;
+std::chrono::steady_clock::time_point origin;
+
+ThreadTrace *localTrace() {
+    static thread_local ThreadTrace *trace = nullptr;
+    if (!trace) {
+        QMutexLocker locker(&registryMutex);
+        trace = new ThreadTrace;
+        trace->threadId = threadTraces.size() + 1;
+        trace->written = 0;
+        trace->events.resize(ringCapacity);
+        threadTraces.append(trace);
+    }
+    return trace;
+}
+
+}
+
+std::atomic<bool> TraceRecorder::enabledFlag(false);
+
+void TraceRecorder::start(int eventsPerThread) {
+    QMutexLocker locker(&registryMutex);
+    ringCapacity = qMax(1, eventsPerThread);
+    origin = std::chrono::steady_clock::now();
+    enabledFlag.store(true, std::memory_order_release);
+}
+
+void TraceRecorder::stop() {
+    enabledFlag.store(false, std::memory_order_release);
+}
+
+bool TraceRecorder::isEnabled() {
+    return enabledFlag.load(std::memory_order_relaxed);
+}
+
+// Nanoseconds since start().
+qint64 TraceRecorder::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+void TraceRecorder::record(const char *category, const char *name, qint64 begin, qint64 end) {
+    ThreadTrace *trace = localTrace();
+    TraceEvent &event = trace->events[int(trace->written % quint64(trace->events.size()))];
+    event.category = category;
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    trace->written++;
+}
+
+// Call after the traced threads have finished or stop() has been called.
+bool TraceRecorder::write(const QString &path) {
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) return false;
+
+    QTextStream out(&file);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+
+    QMutexLocker locker(&registryMutex);
+    for (const ThreadTrace *trace : threadTraces) {
+        quint64 capacity = trace->events.size();
+        quint64 oldest = trace->written > capacity ? trace->written - capacity : 0;
+        for (quint64 i = oldest; i < trace->written; ++i) {
+            const TraceEvent &event = trace->events[int(i % capacity)];
+            if (!first) out << ",\n";
+            first = false;
+            out << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category
+                << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << trace->threadId
+                << ",\"ts\":" << QString::number(event.begin / 1000.0, 'f', 3)
+                << ",\"dur\":" << QString::number((event.end - event.begin) / 1000.0, 'f', 3) << "}";
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    return true;
+}
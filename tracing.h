@@ -0,0 +1,47 @@
+#ifndef TRACING_H
+#define TRACING_H
+
+#include <QtGlobal>
+#include <QString>
+#include <atomic>
+#include <chrono>
+
+// Span tracer that writes Chrome trace JSON (chrome://tracing, Perfetto).
+// Each thread appends fixed-size events to its own preallocated ring, so a
+// span costs two clock reads and a store; nothing is formatted until write().
+class TraceRecorder {
+public:
+    // Starts recording, keeping the newest eventsPerThread spans per thread.
+    static void start(int eventsPerThread = 1 << 16);
+    static void stop();
+    static bool isEnabled();
+    static qint64 now();
+
+    static void record(const char *category, const char *name, qint64 begin, qint64 end);
+    static bool write(const QString &path);
+
+private:
+    static std::atomic<bool> enabledFlag;
+};
+
+class TraceSpan {
+public:
+    TraceSpan(const char *category, const char *name)
+        : category(category), name(name), begin(TraceRecorder::isEnabled() ? TraceRecorder::now() : -1) {}
+
+    ~TraceSpan() {
+        if (begin >= 0) TraceRecorder::record(category, name, begin, TraceRecorder::now());
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+private:
+    const char *category;
+    const char *name;
+    qint64 begin;
+};
+
+#define TRACE_SPAN(category, name) TraceSpan traceSpan(category, name)
+
+#endif // TRACING_H